@@ -2630,6 +2630,11 @@ void D_DoomMain (void)
 					G_TimeDemo(v);
 					D_DoomLoop();	// never returns
 				}
+				else if ((v = Args->CheckValue("-benchdemo")) != nullptr)
+				{
+					G_BenchDemo(v);
+					D_DoomLoop();	// never returns
+				}
 				else
 				{
 					if (gameaction != ga_loadgame && gameaction != ga_loadgamehidecon)
@@ -73,6 +73,15 @@
 #include "intermission/intermission.h"
 #include "g_levellocals.h"
 #include "events.h"
+#include "stats.h"
+#include "i_time.h"
+#include "ctpl.h"
+
+#include <mutex>
+#include <condition_variable>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 // MACROS ------------------------------------------------------------------
 
@@ -105,6 +114,14 @@
 #define GCSWEEPCOST		10
 #define GCFINALIZECOST	100
 
+// Number of single steps between checks of the step budget.
+#define GCBUDGETCHECK	8
+
+// Object pool size classes. Objects larger than POOLMAXSIZE are never pooled.
+#define POOLGRANULARITY	16
+#define POOLMAXSIZE		8192
+#define DEFAULT_POOLLIMIT	(16 << 20)
+
 // TYPES -------------------------------------------------------------------
 
 // This object is responsible for marking sectors during the propagate
@@ -151,10 +168,32 @@ int StepMul = DEFAULT_GCMUL;
 int StepCount;
 size_t Dept;
 bool FinalGC;
+double CollectTime;
+int StepBudget;
+const int PauseBucketLimits[NUM_PAUSE_BUCKETS - 1] = { 50, 100, 250, 500, 1000, 2000, 5000, 10000 };
+unsigned PauseHistogram[NUM_PAUSE_BUCKETS];
+uint64_t MaxPause, LastPause;
+unsigned BudgetStops;
+int MarkThreads;
+size_t PoolLimit = DEFAULT_POOLLIMIT;
+unsigned PoolHits, PoolMisses;
 
 // PRIVATE DATA DEFINITIONS ------------------------------------------------
 
+// Free lists of object memory, one per size class. The first pointer of
+// each free block links to the next one.
+static void *ObjectPool[POOLMAXSIZE / POOLGRANULARITY + 1];
+static size_t PoolBytes;
+
+// Set while worker threads are propagating marks. Gray objects then go to
+// the marking thread's own stack instead of the Gray list.
+static bool MarkingInParallel;
+static thread_local std::vector<DObject *> *LocalGray;
+static ctpl::thread_pool *MarkPool;
+
 static DSectorMarker *SectorMarker;
+static int BudgetTic = -1;			// gametic the budget was last reset for
+static uint64_t BudgetUsed;			// in ns, within BudgetTic
 
 // CODE --------------------------------------------------------------------
 
@@ -171,6 +210,177 @@ void SetThreshold()
 	Threshold = (Estimate / 100) * Pause;
 }
 
+//==========================================================================
+//
+// RecordPause
+//
+// Adds a collector pause to the statistics.
+//
+//==========================================================================
+
+static void RecordPause(uint64_t start, uint64_t end)
+{
+	uint64_t us = (end - start) / 1000;
+	int i;
+
+	for (i = 0; i < NUM_PAUSE_BUCKETS - 1 && us >= (uint64_t)PauseBucketLimits[i]; ++i)
+	{
+	}
+	PauseHistogram[i]++;
+	LastPause = us;
+	MaxPause = MAX(MaxPause, us);
+	CollectTime += (end - start) / 1e6;
+}
+
+void ResetPauseStats()
+{
+	memset(PauseHistogram, 0, sizeof(PauseHistogram));
+	MaxPause = LastPause = 0;
+	BudgetStops = 0;
+}
+
+//==========================================================================
+//
+// BudgetLeft
+//
+// Returns how many nanoseconds of the step budget are left for the
+// current tic. The budget is reset whenever gametic advances. It is
+// ignored once the collector has fallen so far behind that the heap has
+// grown past twice its estimated live size, so that a tight budget cannot
+// make memory use grow without bounds.
+//
+//==========================================================================
+
+static uint64_t BudgetLeft()
+{
+	if (StepBudget <= 0 || FinalGC || Dept > Estimate)
+	{
+		return ~(uint64_t)0;
+	}
+	if (gametic != BudgetTic)
+	{
+		BudgetTic = gametic;
+		BudgetUsed = 0;
+	}
+	uint64_t budget = (uint64_t)StepBudget * 1000;
+	return BudgetUsed < budget ? budget - BudgetUsed : 0;
+}
+
+//==========================================================================
+//
+// AllocObject
+//
+// Pooled memory stays counted in AllocBytes, so reusing it does not count
+// as a new allocation for the purpose of pacing the collector.
+//
+//==========================================================================
+
+void *AllocObject(size_t size)
+{
+	size_t rounded = (size + POOLGRANULARITY - 1) & ~(size_t)(POOLGRANULARITY - 1);
+	if (rounded > POOLMAXSIZE)
+	{
+		return M_Malloc(size);
+	}
+	void *&head = ObjectPool[rounded / POOLGRANULARITY];
+	if (head != nullptr)
+	{
+		void *mem = head;
+		head = *(void **)mem;
+		PoolBytes -= rounded;
+		PoolHits++;
+		return mem;
+	}
+	PoolMisses++;
+	return M_Malloc(rounded);
+}
+
+//==========================================================================
+//
+// FreeObject
+//
+//==========================================================================
+
+void FreeObject(void *mem, size_t size)
+{
+	size_t rounded = (size + POOLGRANULARITY - 1) & ~(size_t)(POOLGRANULARITY - 1);
+	if (rounded > POOLMAXSIZE || PoolBytes + rounded > PoolLimit)
+	{
+		M_Free(mem);
+		return;
+	}
+	void *&head = ObjectPool[rounded / POOLGRANULARITY];
+	*(void **)mem = head;
+	head = mem;
+	PoolBytes += rounded;
+}
+
+//==========================================================================
+//
+// TrimObjectPool
+//
+//==========================================================================
+
+void TrimObjectPool()
+{
+	for (int i = POOLMAXSIZE / POOLGRANULARITY; i > 0 && PoolBytes > PoolLimit; i--)
+	{
+		while (ObjectPool[i] != nullptr && PoolBytes > PoolLimit)
+		{
+			void *mem = ObjectPool[i];
+			ObjectPool[i] = *(void **)mem;
+			PoolBytes -= i * POOLGRANULARITY;
+			M_Free(mem);
+		}
+	}
+}
+
+//==========================================================================
+//
+// PushGray
+//
+// Puts a gray object where the marker will find it.
+//
+//==========================================================================
+
+static void PushGray(DObject *obj)
+{
+	if (MarkingInParallel)
+	{
+		LocalGray->push_back(obj);
+	}
+	else
+	{
+		obj->GCNext = Gray;
+		Gray = obj;
+	}
+}
+
+//==========================================================================
+//
+// ClaimWhite
+//
+// Atomically turns a white object gray. Returns false if another marking
+// thread got to it first.
+//
+//==========================================================================
+
+static bool ClaimWhite(DObject *obj)
+{
+	uint32_t old = obj->ObjectFlags;
+	while (old & OF_WhiteBits)
+	{
+#ifdef _MSC_VER
+		uint32_t prev = (uint32_t)_InterlockedCompareExchange((volatile long *)&obj->ObjectFlags, long(old & ~OF_WhiteBits), long(old));
+		if (prev == old) return true;
+		old = prev;
+#else
+		if (__atomic_compare_exchange_n(&obj->ObjectFlags, &old, old & ~OF_WhiteBits, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) return true;
+#endif
+	}
+	return false;
+}
+
 //==========================================================================
 //
 // PropagateMark
@@ -232,7 +442,16 @@ static DObject **SweepList(DObject **p, size_t count, size_t *finalize_count)
 				curr->Destroy();
 			}
 			curr->ObjectFlags |= OF_Cleanup;
-			delete curr;
+			if ((curr->ObjectFlags & OF_Pooled) && !FinalGC && !PClass::bShutdown)
+			{
+				size_t size = curr->GetClass()->Size;
+				curr->~DObject();
+				FreeObject(curr, size);
+			}
+			else
+			{
+				delete curr;
+			}
 			finalized++;
 		}
 	}
@@ -264,13 +483,165 @@ void Mark(DObject **obj)
 		}
 		else if (lobj->IsWhite())
 		{
-			lobj->White2Gray();
-			lobj->GCNext = Gray;
-			Gray = lobj;
+			if (!MarkingInParallel)
+			{
+				lobj->White2Gray();
+				lobj->GCNext = Gray;
+				Gray = lobj;
+			}
+			else if (ClaimWhite(lobj))
+			{
+				LocalGray->push_back(lobj);
+			}
 		}
 	}
 }
 
+//==========================================================================
+//
+// FParallelMarker
+//
+// Drains the gray list with several threads. Each thread works on its own
+// stack and hands half of it to the shared pool whenever another thread
+// has run out of work. Marking is finished when every thread is idle and
+// the shared pool is empty.
+//
+// Once Limit bytes have been marked, all threads stop and put what is left
+// of their stacks back into the shared pool, which then goes back onto the
+// gray list. The threads report their work in batches, so they may
+// overshoot the limit by a few objects each.
+//
+// The mutator is stopped while this runs, so no write barriers can fire.
+// Objects left over are gray, so the usual tri-color invariant holds
+// whenever this returns.
+//
+//==========================================================================
+
+struct FParallelMarker
+{
+	enum { TAKE_COUNT = 256, SHARE_THRESHOLD = 64, REPORT_COUNT = 32 };
+
+	std::mutex Lock;
+	std::condition_variable Wake;
+	std::vector<DObject *> Shared;
+	std::atomic<int> Idle{0};
+	std::atomic<size_t> Marked{0};
+	std::atomic<bool> Stopped{false};
+	size_t Limit;
+	int Workers;
+	bool Done = false;
+
+	void Run()
+	{
+		std::vector<DObject *> local;
+		size_t marked = 0;
+		unsigned count = 0;
+
+		LocalGray = &local;
+		for (;;)
+		{
+			while (!local.empty() && !Stopped)
+			{
+				DObject *obj = local.back();
+				local.pop_back();
+				obj->Gray2Black();
+				marked += !(obj->ObjectFlags & OF_EuthanizeMe) ? obj->PropagateMark() : obj->GetClass()->Size;
+
+				if (++count % REPORT_COUNT == 0)
+				{
+					if ((Marked += marked) >= Limit) Stopped = true;
+					marked = 0;
+				}
+				if (local.size() > SHARE_THRESHOLD && Idle > 0)
+				{
+					std::lock_guard<std::mutex> lock(Lock);
+					size_t half = local.size() / 2;
+					Shared.insert(Shared.end(), local.end() - half, local.end());
+					local.resize(local.size() - half);
+					Wake.notify_all();
+				}
+			}
+
+			std::unique_lock<std::mutex> lock(Lock);
+			if (Stopped)
+			{
+				Shared.insert(Shared.end(), local.begin(), local.end());
+				local.clear();
+				Wake.notify_all();
+				break;
+			}
+			if (Shared.empty())
+			{
+				if (++Idle == Workers)
+				{
+					Done = true;
+					Wake.notify_all();
+					break;
+				}
+				Wake.wait(lock, [this] { return Done || Stopped || !Shared.empty(); });
+				if (Done || Stopped) break;
+				Idle--;
+			}
+			size_t take = MIN<size_t>(Shared.size(), TAKE_COUNT);
+			local.insert(local.end(), Shared.end() - take, Shared.end());
+			Shared.resize(Shared.size() - take);
+		}
+		LocalGray = nullptr;
+		Marked += marked;
+	}
+};
+
+//==========================================================================
+//
+// ParallelPropagate
+//
+// Propagates pending marks using MarkThreads threads until about limit
+// bytes have been marked. Objects that were not reached go back onto the
+// gray list for the next step.
+//
+//==========================================================================
+
+static size_t ParallelPropagate(size_t limit)
+{
+	FParallelMarker marker;
+	marker.Workers = MarkThreads;
+	marker.Limit = limit;
+	for (; Gray != nullptr; Gray = Gray->GCNext)
+	{
+		marker.Shared.push_back(Gray);
+	}
+
+	// DObject::PropagateMark builds these on demand, which is not thread safe.
+	if (!PClass::bShutdown)
+	{
+		for (auto cls : PClass::AllClasses)
+		{
+			cls->BuildFlatPointers();
+			cls->BuildArrayPointers();
+		}
+	}
+
+	if (MarkPool == nullptr) MarkPool = new ctpl::thread_pool(MarkThreads - 1);
+	else if (MarkPool->size() < MarkThreads - 1) MarkPool->resize(MarkThreads - 1);
+
+	MarkingInParallel = true;
+	std::vector<std::future<void>> jobs;
+	for (int i = 1; i < MarkThreads; i++)
+	{
+		jobs.push_back(MarkPool->push([&](int) { marker.Run(); }));
+	}
+	marker.Run();
+	for (auto &job : jobs) job.wait();
+	MarkingInParallel = false;
+
+	for (auto obj : marker.Shared)
+	{
+		obj->GCNext = Gray;
+		Gray = obj;
+	}
+	return marker.Marked;
+}
+
 //==========================================================================
 //
 // MarkArray
@@ -303,7 +674,7 @@ static void MarkRoot()
 	Mark(StatusBar);
 	M_MarkMenus();
 	Mark(DIntermissionController::CurrentIntermission);
-	DThinker::MarkRoots();
+	DThinker::MarkRoots(MarkThreads > 1);
 	Mark(E_FirstEventHandler);
 	Mark(E_LastEventHandler);
 	level.Mark();
@@ -378,11 +749,12 @@ static void Atomic()
 //
 // SingleStep
 //
-// Performs one step of the collector.
+// Performs one step of the collector. lim is how much work the caller
+// still allows for, which only limits parallel marking.
 //
 //==========================================================================
 
-static size_t SingleStep()
+static size_t SingleStep(size_t lim = ~(size_t)0)
 {
 	switch (State)
 	{
@@ -393,7 +765,7 @@ static size_t SingleStep()
 	case GCS_Propagate:
 		if (Gray != NULL)
 		{
-			return PropagateMark();
+			return MarkThreads > 1 ? ParallelPropagate(lim) : PropagateMark();
 		}
 		else
 		{ // no more gray objects
@@ -430,12 +802,15 @@ static size_t SingleStep()
 // Step
 //
 // Performs enough single steps to cover GCSTEPSIZE * StepMul% bytes of
-// memory.
+// memory, or as many as fit into what is left of the step budget.
 //
 //==========================================================================
 
 void Step()
 {
+	uint64_t start = I_nsTime();
+	uint64_t budget = BudgetLeft();
+
 	size_t lim = (GCSTEPSIZE/100) * StepMul;
 	size_t olim;
 	if (lim == 0)
@@ -443,10 +818,22 @@ void Step()
 		lim = (~(size_t)0) / 2;		// no limit
 	}
 	Dept += AllocBytes - Threshold;
+	if (budget == 0)
+	{
+		// Out of time for this tic. Try again after some more allocations.
+		Threshold = AllocBytes + GCSTEPSIZE;
+		return;
+	}
+	int steps = 0;
 	do
 	{
 		olim = lim;
-		lim -= SingleStep();
+		lim -= SingleStep(lim);
+		if (++steps % GCBUDGETCHECK == 0 && I_nsTime() - start >= budget)
+		{
+			BudgetStops++;
+			break;
+		}
 	} while (olim > lim && State != GCS_Pause);
 	if (State != GCS_Pause)
 	{
@@ -466,6 +853,10 @@ void Step()
 		SetThreshold();
 	}
 	StepCount++;
+
+	uint64_t end = I_nsTime();
+	BudgetUsed += end - start;
+	RecordPause(start, end);
 }
 
 //==========================================================================
@@ -478,6 +869,8 @@ void Step()
 
 void FullGC()
 {
+	uint64_t start = I_nsTime();
+
 	if (State <= GCS_Propagate)
 	{
 		// Reset sweep mark to sweep all elements (returning them to white)
@@ -497,6 +890,8 @@ void FullGC()
 		SingleStep();
 	}
 	SetThreshold();
+
+	RecordPause(start, I_nsTime());
 }
 
 //==========================================================================
@@ -682,8 +1077,7 @@ size_t DSectorMarker::PropagateMark()
 	if (moretodo)
 	{
 		Black2Gray();
-		GCNext = GC::Gray;
-		GC::Gray = this;
+		GC::PushGray(this);
 	}
 	return marked;
 }
@@ -714,6 +1108,13 @@ ADD_STAT(gc)
 	{
 		out.AppendFormat("  %zuK", (GC::Dept + 1023) >> 10);
 	}
+	if (GC::MarkThreads > 1)
+	{
+		out.AppendFormat("  Mark threads: %d", GC::MarkThreads);
+	}
+	out.AppendFormat("\nPool: %6zuK  hits %u  misses %u  ", (GC::PoolBytes + 1023) >> 10, GC::PoolHits, GC::PoolMisses);
+	out.AppendFormat("Pause: last %4llu us  max %5llu us  budget %d us  cut short: %u",
+		(unsigned long long)GC::LastPause, (unsigned long long)GC::MaxPause, GC::StepBudget, GC::BudgetStops);
 	return out;
 }
 
@@ -729,7 +1130,7 @@ CCMD(gc)
 {
 	if (argv.argc() == 1)
 	{
-		Printf ("Usage: gc stop|now|full|count|pause [size]|stepmul [size]\n");
+		Printf ("Usage: gc stop|now|full|count|pause [size]|stepmul [size]|budget [usec]|pauses [reset]|threads [count]|pool [kbytes]\n");
 		return;
 	}
 	if (stricmp(argv[1], "stop") == 0)
@@ -772,5 +1173,62 @@ CCMD(gc)
 			GC::StepMul = MAX(100, atoi(argv[2]));
 		}
 	}
+	else if (stricmp(argv[1], "budget") == 0)
+	{
+		if (argv.argc() == 2)
+		{
+			Printf ("Current GC step budget is %d us per tic\n", GC::StepBudget);
+		}
+		else
+		{
+			GC::StepBudget = MAX(0, atoi(argv[2]));
+		}
+	}
+	else if (stricmp(argv[1], "threads") == 0)
+	{
+		if (argv.argc() == 2)
+		{
+			Printf ("Current GC mark thread count is %d\n", GC::MarkThreads);
+		}
+		else
+		{
+			GC::MarkThreads = clamp(atoi(argv[2]), 0, 64);
+		}
+	}
+	else if (stricmp(argv[1], "pool") == 0)
+	{
+		if (argv.argc() == 2)
+		{
+			unsigned total = GC::PoolHits + GC::PoolMisses;
+			Printf ("Object pool: %zuK of %zuK used, %u of %u allocations reused (%.1f%%)\n",
+				(GC::PoolBytes + 1023) >> 10, GC::PoolLimit >> 10, GC::PoolHits, total,
+				total == 0 ? 0. : GC::PoolHits * 100. / total);
+		}
+		else
+		{
+			GC::PoolLimit = (size_t)MAX(0, atoi(argv[2])) << 10;
+			GC::TrimObjectPool();
+		}
+	}
+	else if (stricmp(argv[1], "pauses") == 0)
+	{
+		if (argv.argc() > 2 && stricmp(argv[2], "reset") == 0)
+		{
+			GC::ResetPauseStats();
+			return;
+		}
+		unsigned total = 0;
+		for (int i = 0; i < GC::NUM_PAUSE_BUCKETS; i++) total += GC::PauseHistogram[i];
+		for (int i = 0; i < GC::NUM_PAUSE_BUCKETS; i++)
+		{
+			FString range;
+			if (i == GC::NUM_PAUSE_BUCKETS - 1) range.Format(">= %d us", GC::PauseBucketLimits[i - 1]);
+			else range.Format("< %d us", GC::PauseBucketLimits[i]);
+			Printf("%12s: %8u (%5.1f%%)\n", range.GetChars(), GC::PauseHistogram[i],
+				total == 0 ? 0. : GC::PauseHistogram[i] * 100. / total);
+		}
+		Printf("%u pauses, longest %llu us, %u cut short by the budget\n", total,
+			(unsigned long long)GC::MaxPause, GC::BudgetStops);
+	}
 }
 
@@ -25,6 +25,7 @@ enum EObjectFlags
 	OF_Transient		= 1 << 11,		// Object should not be archived (references to it will be nulled on disk)
 	OF_Spawned			= 1 << 12,      // Thinker was spawned at all (some thinkers get deleted before spawning)
 	OF_Released			= 1 << 13,		// Object was released from the GC system and should not be processed by GC function
+	OF_Pooled			= 1 << 14,		// Object's memory came from GC::AllocObject and can be reused by the collector
 };
 
 template<class T> class TObjPtr;
@@ -69,6 +70,49 @@ namespace GC
 	// Is this the final collection just before exit?
 	extern bool FinalGC;
 
+	// Total time spent in Step() and FullGC(), in milliseconds.
+	extern double CollectTime;
+
+	// Maximum time Step() may spend per tic, in microseconds. 0 means no limit.
+	extern int StepBudget;
+
+	// Upper bounds of the pause histogram buckets, in microseconds. The last
+	// bucket catches everything longer.
+	enum { NUM_PAUSE_BUCKETS = 9 };
+	extern const int PauseBucketLimits[NUM_PAUSE_BUCKETS - 1];
+
+	// Number of collector pauses that fell into each bucket.
+	extern unsigned PauseHistogram[NUM_PAUSE_BUCKETS];
+
+	// Longest and most recent pause, in microseconds.
+	extern uint64_t MaxPause, LastPause;
+
+	// Number of steps that were cut short because the budget ran out.
+	extern unsigned BudgetStops;
+
+	// Clears the pause statistics.
+	void ResetPauseStats();
+
+	// Maximum number of bytes of dead objects kept around for reuse.
+	extern size_t PoolLimit;
+
+	// Allocations that were satisfied from the pool, and those that were not.
+	extern unsigned PoolHits, PoolMisses;
+
+	// Allocates memory for a new object, preferably from the memory of an
+	// object of the same size class that the collector freed earlier.
+	void *AllocObject(size_t size);
+
+	// Returns the memory of an already destructed object to the pool.
+	void FreeObject(void *mem, size_t size);
+
+	// Releases pooled memory until the pool is no larger than PoolLimit.
+	void TrimObjectPool();
+
+	// Number of threads used to propagate marks. 0 or 1 marks incrementally
+	// on the main thread.
+	extern int MarkThreads;
+
 	// Current white value for known-dead objects.
 	static inline uint32_t OtherWhite()
 	{
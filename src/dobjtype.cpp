@@ -448,7 +448,7 @@ PClass *PClass::FindClass (FName zaname)
 
 DObject *PClass::CreateNew()
 {
-	uint8_t *mem = (uint8_t *)M_Malloc (Size);
+	uint8_t *mem = (uint8_t *)GC::AllocObject (Size);
 	assert (mem != nullptr);
 
 	// Set this object's defaults before constructing it.
@@ -463,6 +463,7 @@ DObject *PClass::CreateNew()
 		I_Error("Attempt to instantiate abstract class %s.", TypeName.GetChars());
 	}
 	ConstructNative (mem);
+	((DObject *)mem)->ObjectFlags |= OF_Pooled;
 	((DObject *)mem)->SetClass (const_cast<PClass *>(this));
 	InitializeSpecials(mem, Defaults, &PClass::SpecialInits);
 	return (DObject *)mem;
@@ -40,10 +40,12 @@
 #include "vm.h"
 #include "c_dispatch.h"
 #include "v_text.h"
+#include "doomstat.h"
 
 
 static int ThinkCount;
 static cycle_t ThinkCycles;
+static cycle_t StatCycles[MAX_STATNUM+1];	// accumulated per statnum while benchmarking
 extern cycle_t BotSupportCycles;
 extern cycle_t ActionCycles;
 extern int BotWTG;
@@ -410,7 +412,7 @@ DEFINE_ACTION_FUNCTION_NATIVE(DThinker, ChangeStatNum, ChangeStatNum)
 //
 //==========================================================================
 
-void DThinker::MarkRoots()
+void DThinker::MarkRoots(bool splitlists)
 {
 	for (int i = 0; i <= MAX_STATNUM; ++i)
 	{
@@ -418,6 +420,27 @@ void DThinker::MarkRoots()
 		GC::Mark(FreshThinkers[i].Sentinel);
 	}
 	GC::Mark(Thinkers[MAX_STATNUM+1].Sentinel);
+
+	// Marking every thinker directly gives the parallel marker independent
+	// pieces of work instead of one long NextThinker chain per list.
+	if (splitlists)
+	{
+		auto markall = [](FThinkerList &list)
+		{
+			if (list.Sentinel == nullptr) return;
+			for (DThinker *node = list.Sentinel->NextThinker; node != nullptr && node != list.Sentinel; node = node->NextThinker)
+			{
+				DThinker *mark = node;
+				GC::Mark(mark);
+			}
+		};
+		for (int i = 0; i <= MAX_STATNUM; ++i)
+		{
+			markall(Thinkers[i]);
+			markall(FreshThinkers[i]);
+		}
+		markall(Thinkers[MAX_STATNUM+1]);
+	}
 }
 
 //==========================================================================
@@ -605,7 +628,9 @@ void DThinker::RunThinkers ()
 		// Tick every thinker left from last time
 		for (i = STAT_FIRST_THINKING; i <= MAX_STATNUM; ++i)
 		{
+			if (benchmarkdemo) StatCycles[i].Clock();
 			TickThinkers(&Thinkers[i], NULL);
+			if (benchmarkdemo) StatCycles[i].Unclock();
 		}
 
 		// Keep ticking the fresh thinkers until there are no new ones.
@@ -614,7 +639,9 @@ void DThinker::RunThinkers ()
 			count = 0;
 			for (i = STAT_FIRST_THINKING; i <= MAX_STATNUM; ++i)
 			{
+				if (benchmarkdemo) StatCycles[i].Clock();
 				count += TickThinkers(&FreshThinkers[i], &Thinkers[i]);
+				if (benchmarkdemo) StatCycles[i].Unclock();
 			}
 		} while (count != 0);
 	}
@@ -698,6 +725,23 @@ void DThinker::RunThinkers ()
 	ThinkCycles.Unclock();
 }
 
+//==========================================================================
+//
+// Per-statnum think time, accumulated across tics while a benchmark
+// demo is running.
+//
+//==========================================================================
+
+void DThinker::ResetStatTimes()
+{
+	for (auto &c : StatCycles) c.Reset();
+}
+
+double DThinker::StatTimeMS(int statnum)
+{
+	return (unsigned)statnum <= MAX_STATNUM ? StatCycles[statnum].TimeMS() : 0;
+}
+
 //==========================================================================
 //
 //
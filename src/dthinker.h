@@ -86,7 +86,9 @@ public:
 		DestroyThinkersInList(FreshThinkers[statnum]);
 	}
 	static void SerializeThinkers(FSerializer &arc, bool keepPlayers);
-	static void MarkRoots();
+	static void MarkRoots(bool splitlists = false);
+	static void ResetStatTimes();
+	static double StatTimeMS(int statnum);
 
 	static DThinker *FirstThinker (int statnum);
 	static bool bSerialOverride;
@@ -36,6 +36,16 @@
 #include "files.h"
 #include "templates.h"
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 
 
 //==========================================================================
@@ -337,6 +347,84 @@ public:
 
 
 
+//==========================================================================
+//
+// MappedFileReader
+//
+// reads data from a file that is mapped into memory. Since GetBuffer
+// returns the mapping, uncompressed lumps in such a file point their
+// cache directly at it instead of reading a copy. The mapping is copy on
+// write, so code that modifies a cached lump in place only changes its
+// own copy of the page, just like with files loaded into memory.
+//
+// Mapping is refused on 32-bit builds and for very large files, where a
+// few big resource files could use up the address space.
+//
+//==========================================================================
+
+class MappedFileReader : public MemoryReader
+{
+	enum { MAX_MAPPED_SIZE = 512 << 20 };
+
+#ifdef _WIN32
+	HANDLE hFile = INVALID_HANDLE_VALUE;
+	HANDLE hMapping = NULL;
+#endif
+
+public:
+	MappedFileReader()
+	{}
+
+	~MappedFileReader()
+	{
+#ifdef _WIN32
+		if (bufptr != nullptr) UnmapViewOfFile(bufptr);
+		if (hMapping != NULL) CloseHandle(hMapping);
+		if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+#else
+		if (bufptr != nullptr) munmap((void *)bufptr, Length);
+#endif
+	}
+
+	bool Open(const char *filename)
+	{
+		if (sizeof(void *) < 8) return false;
+
+#ifdef _WIN32
+		hFile = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (hFile == INVALID_HANDLE_VALUE) return false;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(hFile, &size) || size.QuadPart <= 0 || size.QuadPart > MAX_MAPPED_SIZE) return false;
+
+		hMapping = CreateFileMappingA(hFile, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+		if (hMapping == NULL) return false;
+
+		bufptr = (const char *)MapViewOfFile(hMapping, FILE_MAP_COPY, 0, 0, 0);
+		if (bufptr == nullptr) return false;
+		Length = (long)size.QuadPart;
+#else
+		int fd = open(filename, O_RDONLY);
+		if (fd < 0) return false;
+
+		struct stat info;
+		if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0 || info.st_size > MAX_MAPPED_SIZE)
+		{
+			close(fd);
+			return false;
+		}
+
+		void *map = mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		close(fd);	// the mapping stays valid after the descriptor is closed.
+		if (map == MAP_FAILED) return false;
+		bufptr = (const char *)map;
+		Length = (long)info.st_size;
+#endif
+		FilePos = 0;
+		return true;
+	}
+};
+
 //==========================================================================
 //
 // FileReader
@@ -358,6 +446,19 @@ bool FileReader::OpenFile(const char *filename, FileReader::Size start, FileRead
 	return true;
 }
 
+bool FileReader::OpenMappedFile(const char *filename)
+{
+	auto reader = new MappedFileReader;
+	if (!reader->Open(filename))
+	{
+		delete reader;
+		return false;
+	}
+	Close();
+	mReader = reader;
+	return true;
+}
+
 bool FileReader::OpenFilePart(FileReader &parent, FileReader::Size start, FileReader::Size length)
 {
 	auto reader = new FileReaderRedirect(parent, (long)start, (long)length);
@@ -75,7 +75,9 @@
 #include "g_hub.h"
 #include "g_levellocals.h"
 #include "events.h"
+#include "stats.h"
 
+extern int VMCalls[10];
 
 static FRandom pr_dmspawn ("DMSpawn");
 static FRandom pr_pspawn ("PlayerSpawn");
@@ -93,6 +95,8 @@ void	G_DoVictory (void);
 void	G_DoWorldDone (void);
 void	G_DoSaveGame (bool okForQuicksave, FString filename, const char *description);
 void	G_DoAutoSave ();
+static void G_BenchmarkTicker ();
+static void G_WriteBenchmarkReport ();
 
 void STAT_Serialize(FSerializer &file);
 bool WriteZip(const char *filename, TArray<FString> &filenames, TArray<FCompressedBuffer> &content);
@@ -141,6 +145,7 @@ bool			insave;					// Game is saving - used to block exit commands
 bool			timingdemo; 			// if true, exit with report on completion 
 bool 			nodrawers;				// for comparative timing purposes 
 bool 			noblit; 				// for comparative timing purposes 
+bool			benchmarkdemo;			// timedemo without drawing or sound, exits with a machine-readable report
 
 bool	 		viewactive;
 
@@ -1192,7 +1197,14 @@ void G_Ticker ()
 	switch (gamestate)
 	{
 	case GS_LEVEL:
-		P_Ticker ();
+		if (benchmarkdemo)
+		{
+			G_BenchmarkTicker ();
+		}
+		else
+		{
+			P_Ticker ();
+		}
 		AM_Ticker ();
 		break;
 
@@ -2745,6 +2757,131 @@ void G_TimeDemo (const char* name)
 	gameaction = (gameaction == ga_loadgame) ? ga_loadgameplaydemo : ga_playdemo;
 }
 
+//==========================================================================
+//
+// G_BenchDemo
+//
+// Plays back a demo as fast as possible without drawing anything and
+// only times the playsim. Level loading, intermissions and the renderer
+// are excluded so that the result reflects thinker throughput alone.
+//
+//==========================================================================
+
+static struct
+{
+	double TicTimeMS;
+	double PeakTicMS;
+	double StartGCTime;
+	uint64_t VMCalls;
+	int Tics;
+} BenchStats;
+
+void G_BenchDemo (const char* name)
+{
+	G_TimeDemo (name);
+	nodrawers = true;
+	noblit = true;
+	benchmarkdemo = true;
+
+	BenchStats.TicTimeMS = 0;
+	BenchStats.PeakTicMS = 0;
+	BenchStats.StartGCTime = GC::CollectTime;
+	BenchStats.VMCalls = 0;
+	BenchStats.Tics = 0;
+	DThinker::ResetStatTimes();
+}
+
+static void G_BenchmarkTicker ()
+{
+	cycle_t tic;
+
+	// Nothing draws the VM stat while benchmarking, so its counter can
+	// be borrowed to count the calls of a single tic.
+	VMCalls[0] = 0;
+	tic.Reset();
+	tic.Clock();
+	P_Ticker ();
+	tic.Unclock();
+
+	double ms = tic.TimeMS();
+	BenchStats.TicTimeMS += ms;
+	BenchStats.PeakTicMS = MAX(BenchStats.PeakTicMS, ms);
+	BenchStats.VMCalls += VMCalls[0];
+	VMCalls[0] = 0;
+	BenchStats.Tics++;
+}
+
+//==========================================================================
+//
+// JsonEscape
+//
+//==========================================================================
+
+static FString JsonEscape (const char *str)
+{
+	FString out;
+	for (; *str != 0; str++)
+	{
+		unsigned char c = *str;
+		if (c == '"' || c == '\\') out.AppendFormat("\\%c", c);
+		else if (c < 0x20) out.AppendFormat("\\u%04x", c);
+		else out += (char)c;
+	}
+	return out;
+}
+
+//==========================================================================
+//
+// G_WriteBenchmarkReport
+//
+// Writes the results of a -benchdemo run as JSON, either to the file
+// given with -benchreport or to the console.
+//
+//==========================================================================
+
+static void G_WriteBenchmarkReport ()
+{
+	FString out;
+	double seconds = BenchStats.TicTimeMS / 1000.;
+
+	out.Format("{\n\t\"demo\": \"%s\",\n", JsonEscape(defdemoname).GetChars());
+	out.AppendFormat("\t\"tics\": %d,\n", BenchStats.Tics);
+	out.AppendFormat("\t\"time_ms\": %.3f,\n", BenchStats.TicTimeMS);
+	out.AppendFormat("\t\"tics_per_sec\": %.3f,\n", seconds > 0 ? BenchStats.Tics / seconds : 0.);
+	out.AppendFormat("\t\"peak_tic_ms\": %.3f,\n", BenchStats.PeakTicMS);
+	out.AppendFormat("\t\"gc_ms\": %.3f,\n", GC::CollectTime - BenchStats.StartGCTime);
+	out.AppendFormat("\t\"vm_calls\": %llu,\n", (unsigned long long)BenchStats.VMCalls);
+	out += "\t\"think_ms\": {";
+
+	bool first = true;
+	for (int i = STAT_FIRST_THINKING; i <= MAX_STATNUM; ++i)
+	{
+		double ms = DThinker::StatTimeMS(i);
+		if (ms > 0)
+		{
+			out.AppendFormat("%s\n\t\t\"%d\": %.3f", first ? "" : ",", i, ms);
+			first = false;
+		}
+	}
+	out += "\n\t}\n}\n";
+
+	const char *filename = Args->CheckValue("-benchreport");
+	if (filename != nullptr)
+	{
+		FILE *f = fopen(filename, "w");
+		if (f == nullptr)
+		{
+			Printf(TEXTCOLOR_RED "Could not write benchmark report to %s\n", filename);
+		}
+		else
+		{
+			fputs(out.GetChars(), f);
+			fclose(f);
+		}
+	}
+	Printf("%s", out.GetChars());
+}
+
 
 /*
 ===================
@@ -2790,7 +2927,12 @@ bool G_CheckDemoStatus (void)
 		}
 		if (singledemo || timingdemo)
 		{
-			if (timingdemo)
+			if (benchmarkdemo)
+			{
+				G_WriteBenchmarkReport ();
+				exit (0);
+			}
+			else if (timingdemo)
 			{
 				// Trying to get back to a stable state after timing a demo
 				// seems to cause problems. I don't feel like fixing that
@@ -65,6 +65,7 @@ void G_BeginRecording (const char *startmap);
 
 void G_PlayDemo (char* name);
 void G_TimeDemo (const char* name);
+void G_BenchDemo (const char* name);
 bool G_CheckDemoStatus (void);
 
 void G_WorldDone (void);
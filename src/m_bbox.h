@@ -87,6 +87,7 @@ public:
 	inline double Right () const { return m_Box[BOXRIGHT]; }
 
 	bool inRange(const line_t *ld) const;
+	bool inRangeSSE(const line_t *ld) const;
 
 	int BoxOnLineSide (const line_t *ld) const;
 
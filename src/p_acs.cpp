@@ -36,6 +36,7 @@
 */
 
 #include <assert.h>
+#include <algorithm>
 
 #include "templates.h"
 #include "doomdef.h"
@@ -75,6 +76,7 @@
 #include "actorinlines.h"
 #include "types.h"
 #include "scriptutil.h"
+#include "i_time.h"
 
 	// P-codes for ACS scripts
 	enum
@@ -1132,6 +1134,53 @@ void ACSStringPool::MarkStringArray(const int *strnum, unsigned int count)
 	}
 }
 
+//============================================================================
+//
+// FWorldGlobalArray :: AllocChunk
+//
+//============================================================================
+
+void FWorldGlobalArray::AllocChunk(unsigned chunk)
+{
+	if (chunk >= Chunks.Size())
+	{
+		unsigned oldsize = Chunks.Size();
+		Chunks.Resize(chunk + 1);
+		std::fill(&Chunks[oldsize], &Chunks[chunk] + 1, nullptr);
+	}
+	Chunks[chunk] = new int32_t[CHUNK_SIZE]();
+}
+
+//============================================================================
+//
+// FWorldGlobalArray :: CountUsed
+//
+//============================================================================
+
+unsigned FWorldGlobalArray::CountUsed() const
+{
+	unsigned count = 0;
+	ForEach([&](int32_t, int32_t) { count++; });
+	return count;
+}
+
+//============================================================================
+//
+// FWorldGlobalArray :: Clear
+//
+//============================================================================
+
+void FWorldGlobalArray::Clear()
+{
+	for (auto chunk : Chunks)
+	{
+		delete[] chunk;
+	}
+	Chunks.Clear();
+	Chunks.ShrinkToFit();
+	Sparse.Clear();
+}
+
 //============================================================================
 //
 // ACSStringPool :: MarkStringMap
@@ -1142,12 +1191,8 @@ void ACSStringPool::MarkStringArray(const int *strnum, unsigned int count)
 
 void ACSStringPool::MarkStringMap(const FWorldGlobalArray &aray)
 {
-	FWorldGlobalArray::ConstIterator it(aray);
-	FWorldGlobalArray::ConstPair *pair;
-
-	while (it.NextPair(pair))
+	aray.ForEach([=](int32_t, int32_t num)
 	{
-		int num = pair->Value;
 		if ((num & LIBRARYID_MASK) == STRPOOL_LIBRARYID_OR)
 		{
 			num &= ~LIBRARYID_MASK;
@@ -1156,7 +1201,7 @@ void ACSStringPool::MarkStringMap(const FWorldGlobalArray &aray)
 				Pool[num].Mark |= true;
 			}
 		}
-	}
+	});
 }
 
 //============================================================================
@@ -1637,15 +1682,12 @@ static void WriteArrayVars (FSerializer &file, FWorldGlobalArray *vars, unsigned
 					arraykey.Format("%d", i);
 					if (file.BeginObject(arraykey))
 					{
-						FWorldGlobalArray::ConstIterator it(vars[i]);
-						const FWorldGlobalArray::Pair *pair;
-
-						while (it.NextPair(pair))
+						vars[i].ForEach([&](int32_t index, int32_t value)
 						{
-							arraykey.Format("%d", pair->Key);
-							int v = pair->Value;
+							arraykey.Format("%d", index);
+							int v = value;
 							file(arraykey.GetChars(), v);
-						}
+						});
 						file.EndObject();
 					}
 				}
@@ -6852,6 +6894,24 @@ static bool CharArrayParms(int &capacity, int &offset, int &a, FACSStackMemory&
 	return true;
 }
 
+// Timing is only collected after `acsprofile start`, because it needs
+// clock reads around every script run and native call.
+static bool ACSTiming;
+
+// Time spent in each ACSF_ function, indexed by function number. This is
+// only allocated while timing is on.
+static TArray<ACSProfileInfo> NativeProfiles;
+
+// Entry times of the ACS functions called during one timed run. These are
+// kept apart from CallReturn so that profiling does not use any space on
+// the script's own stack.
+struct ACSCallTiming
+{
+	int ReturnSP;			// stack position of the function's CallReturn
+	uint64_t EntryTime;
+	uint64_t EntryNativeTime;
+};
+
 int DLevelScript::RunScript ()
 {
 	DACSThinker *controller = DACSThinker::ActiveThinker;
@@ -6941,6 +7001,10 @@ int DLevelScript::RunScript ()
 	const char *lookup;
 	int optstart = -1;
 	int temp;
+	const bool timing = ACSTiming;
+	uint64_t starttime = timing ? I_nsTime() : 0;
+	uint64_t nativetime = 0;
+	TArray<ACSCallTiming> calltimes;
 
 	while (state == SCRIPT_Running)
 	{
@@ -7202,7 +7266,22 @@ int DLevelScript::RunScript ()
 				int argCount = NEXTBYTE;
 				int funcIndex = NEXTSHORT;
 
-				int retval = CallFunction(argCount, funcIndex, &STACK(argCount));
+				int retval;
+				if (!timing)
+				{
+					retval = CallFunction(argCount, funcIndex, &STACK(argCount));
+				}
+				else
+				{
+					uint64_t callstart = I_nsTime();
+					retval = CallFunction(argCount, funcIndex, &STACK(argCount));
+					uint64_t calltime = I_nsTime() - callstart;
+					nativetime += calltime;
+					if ((unsigned)funcIndex < NativeProfiles.Size())
+					{
+						NativeProfiles[funcIndex].AddRun(0, calltime);
+					}
+				}
 				sp -= argCount-1;
 				STACK(1) = retval;
 			}
@@ -7262,6 +7341,10 @@ int DLevelScript::RunScript ()
 				sp += i;
 				::new(&Stack[sp]) CallReturn(activeBehavior->PC2Ofs(pc), activeFunction,
 					activeBehavior, mylocals, localarrays, pcd == PCD_CALLDISCARD, runaway);
+				if (timing)
+				{
+					calltimes.Push({ sp, I_nsTime(), nativetime });
+				}
 				sp += (sizeof(CallReturn) + sizeof(int) - 1) / sizeof(int);
 				pc = module->Ofs2PC (func->Address);
 				localarrays = &func->LocalArrays;
@@ -7291,7 +7374,20 @@ int DLevelScript::RunScript ()
 				}
 				sp -= sizeof(CallReturn)/sizeof(int);
 				retsp = &Stack[sp];
-				activeBehavior->GetFunctionProfileData(activeFunction)->AddRun(runaway - ret->EntryInstrCount);
+				// Only calls made during this run are timed. A function that was
+				// entered before a delay has its frame kept on the script's stack
+				// across runs, but has no entry in calltimes.
+				if (calltimes.Size() > 0 && calltimes.Last().ReturnSP == sp)
+				{
+					ACSCallTiming entry;
+					calltimes.Pop(entry);
+					activeBehavior->GetFunctionProfileData(activeFunction)->AddRun(runaway - ret->EntryInstrCount,
+						I_nsTime() - entry.EntryTime, nativetime - entry.EntryNativeTime);
+				}
+				else
+				{
+					activeBehavior->GetFunctionProfileData(activeFunction)->AddRun(runaway - ret->EntryInstrCount);
+				}
 				sp = int(locals.GetPointer() - &Stack[0]);
 				pc = ret->ReturnModule->Ofs2PC(ret->ReturnAddress);
 				activeFunction = ret->ReturnFunction;
@@ -10272,7 +10368,7 @@ scriptwait:
 		auto scriptptr = activeBehavior->GetScriptPtr(InModuleScriptNumber);
 		if (scriptptr != nullptr)
 		{
-			scriptptr->ProfileData.AddRun(runaway);
+			scriptptr->ProfileData.AddRun(runaway, timing ? I_nsTime() - starttime : 0, nativetime);
 		}
 		else
 		{
@@ -10591,12 +10687,21 @@ void ACSProfileInfo::Reset()
 	NumRuns = 0;
 	MinInstrPerRun = UINT_MAX;
 	MaxInstrPerRun = 0;
+	TotalTime = 0;
+	MaxTimePerRun = 0;
+	NativeTime = 0;
 }
 
-void ACSProfileInfo::AddRun(unsigned int num_instr)
+void ACSProfileInfo::AddRun(unsigned int num_instr, uint64_t time, uint64_t nativetime)
 {
 	TotalInstr += num_instr;
 	NumRuns++;
+	TotalTime += time;
+	NativeTime += nativetime;
+	if (time > MaxTimePerRun)
+	{
+		MaxTimePerRun = time;
+	}
 	if (num_instr < MinInstrPerRun)
 	{
 		MinInstrPerRun = num_instr;
@@ -10651,6 +10756,14 @@ void ClearProfiles(TArray<ProfileCollector> &profiles)
 	}
 }
 
+static void ClearNativeProfiles()
+{
+	for (auto &prof : NativeProfiles)
+	{
+		prof.Reset();
+	}
+}
+
 static int sort_by_total_instr(const void *a_, const void *b_)
 {
 	const ProfileCollector *a = (const ProfileCollector *)a_;
@@ -10695,6 +10808,43 @@ static int sort_by_runs(const void *a_, const void *b_)
 	return b->ProfileData->NumRuns - a->ProfileData->NumRuns;
 }
 
+static int sort_by_time(const void *a_, const void *b_)
+{
+	const ProfileCollector *a = (const ProfileCollector *)a_;
+	const ProfileCollector *b = (const ProfileCollector *)b_;
+
+	uint64_t at = a->ProfileData->TotalTime, bt = b->ProfileData->TotalTime;
+	return at < bt ? 1 : at > bt ? -1 : 0;
+}
+
+//==========================================================================
+//
+// GetProfileName
+//
+//==========================================================================
+
+static FString GetProfileName(const ProfileCollector *prof, bool functions)
+{
+	FString name;
+	if (functions)
+	{
+		uint32_t *fnames = (uint32_t *)prof->Module->FindChunk(MAKE_ID('F','N','A','M'));
+		if (fnames != NULL && prof->Index >= 0 && prof->Index < (int)LittleLong(fnames[2]))
+		{
+			name = (char *)(fnames + 2) + LittleLong(fnames[3+prof->Index]);
+		}
+		else
+		{
+			name.Format("Function %d", prof->Index);
+		}
+	}
+	else
+	{
+		name = ScriptPresentation(prof->Module->GetScriptPtr(prof->Index)->Number).GetChars() + 7;
+	}
+	return name;
+}
+
 static void ShowProfileData(TArray<ProfileCollector> &profiles, long ilimit,
 	int (*sorter)(const void *, const void *), bool functions)
 {
@@ -10722,8 +10872,8 @@ static void ShowProfileData(TArray<ProfileCollector> &profiles, long ilimit,
 		limit = UINT_MAX;
 	}
 
-	Printf(TEXTCOLOR_YELLOW "Module       %-20s      Total    Runs     Avg     Min     Max\n", typelabels[functions]);
-	Printf(TEXTCOLOR_YELLOW "------------ -------------------- ---------- ------- ------- ------- -------\n");
+	Printf(TEXTCOLOR_YELLOW "Module       %-20s      Total    Runs     Avg     Min     Max    Time ms  Max ms\n", typelabels[functions]);
+	Printf(TEXTCOLOR_YELLOW "------------ -------------------- ---------- ------- ------- ------- ------- ---------- -------\n");
 	for (unsigned int i = 0; i < limit && i < profiles.Size(); ++i)
 	{
 		ProfileCollector *prof = &profiles[i];
@@ -10736,35 +10886,106 @@ static void ShowProfileData(TArray<ProfileCollector> &profiles, long ilimit,
 		mysnprintf(modname, sizeof(modname), "%s", prof->Module->GetModuleName());
 
 		// Script/function name
-		if (functions)
-		{
-			uint32_t *fnames = (uint32_t *)prof->Module->FindChunk(MAKE_ID('F','N','A','M'));
-			if (prof->Index >= 0 && prof->Index < (int)LittleLong(fnames[2]))
-			{
-				mysnprintf(scriptname, sizeof(scriptname), "%s",
-					(char *)(fnames + 2) + LittleLong(fnames[3+prof->Index]));
-			}
-			else
-			{
-				mysnprintf(scriptname, sizeof(scriptname), "Function %d", prof->Index);
-			}
-		}
-		else
-		{
-			mysnprintf(scriptname, sizeof(scriptname), "%s",
-				ScriptPresentation(prof->Module->GetScriptPtr(prof->Index)->Number).GetChars() + 7);
-		}
-		Printf("%-12s %-20s%11llu%8u%8u%8u%8u\n",
+		mysnprintf(scriptname, sizeof(scriptname), "%s", GetProfileName(prof, functions).GetChars());
+
+		Printf("%-12s %-20s%11llu%8u%8u%8u%8u%11.3f%8.3f\n",
 			modname, scriptname,
 			prof->ProfileData->TotalInstr,
 			prof->ProfileData->NumRuns,
 			unsigned(prof->ProfileData->TotalInstr / prof->ProfileData->NumRuns),
 			prof->ProfileData->MinInstrPerRun,
-			prof->ProfileData->MaxInstrPerRun
+			prof->ProfileData->MaxInstrPerRun,
+			prof->ProfileData->TotalTime / 1e6,
+			prof->ProfileData->MaxTimePerRun / 1e6
 			);
 	}
 }
 
+//==========================================================================
+//
+// ShowNativeProfiles
+//
+// Lists the ACSF_ functions that took the most time.
+//
+//==========================================================================
+
+static void ShowNativeProfiles(long ilimit)
+{
+	TArray<int> natives;
+
+	for (unsigned int i = 0; i < NativeProfiles.Size(); ++i)
+	{
+		if (NativeProfiles[i].NumRuns > 0) natives.Push(i);
+	}
+	if (natives.Size() == 0)
+	{
+		return;
+	}
+	std::sort(natives.begin(), natives.end(), [](int a, int b)
+	{
+		return NativeProfiles[a].TotalTime > NativeProfiles[b].TotalTime;
+	});
+
+	unsigned int limit = ilimit > 0 ? (unsigned int)ilimit : UINT_MAX;
+	Printf(TEXTCOLOR_ORANGE "Top native functions:\n");
+	Printf(TEXTCOLOR_YELLOW "Function       Calls    Time ms  Max ms\n");
+	Printf(TEXTCOLOR_YELLOW "---------- ---------- ---------- -------\n");
+	for (unsigned int i = 0; i < limit && i < natives.Size(); ++i)
+	{
+		auto &prof = NativeProfiles[natives[i]];
+		Printf("ACSF %-5d %10u%11.3f%8.3f\n", natives[i], prof.NumRuns, prof.TotalTime / 1e6, prof.MaxTimePerRun / 1e6);
+	}
+}
+
+//==========================================================================
+//
+// DumpProfileData
+//
+// Writes everything collected so far to a CSV file. Times are in
+// microseconds.
+//
+//==========================================================================
+
+static void DumpProfileData(const char *filename, TArray<ProfileCollector> &scripts, TArray<ProfileCollector> &functions)
+{
+	FILE *f = fopen(filename, "w");
+	if (f == NULL)
+	{
+		Printf(TEXTCOLOR_RED "Could not open %s for writing\n", filename);
+		return;
+	}
+
+	fprintf(f, "type,module,name,runs,totalinstr,mininstr,maxinstr,totaltime,maxtime,nativetime\n");
+	for (int type = 0; type < 2; type++)
+	{
+		auto &profiles = type == 0 ? scripts : functions;
+		for (unsigned int i = 0; i < profiles.Size(); ++i)
+		{
+			ProfileCollector *prof = &profiles[i];
+			ACSProfileInfo *data = prof->ProfileData;
+			if (data->NumRuns == 0) continue;
+
+			FString name = GetProfileName(prof, type == 1);
+			name.ReplaceChars('"', '\'');
+			fprintf(f, "%s,%s,\"%s\",%u,%llu,%u,%u,%llu,%llu,%llu\n", type == 0 ? "script" : "function",
+				prof->Module->GetModuleName(), name.GetChars(), data->NumRuns, data->TotalInstr,
+				data->MinInstrPerRun, data->MaxInstrPerRun, (unsigned long long)data->TotalTime / 1000,
+				(unsigned long long)data->MaxTimePerRun / 1000, (unsigned long long)data->NativeTime / 1000);
+		}
+	}
+
+	for (unsigned int i = 0; i < NativeProfiles.Size(); ++i)
+	{
+		ACSProfileInfo &prof = NativeProfiles[i];
+		if (prof.NumRuns == 0) continue;
+		fprintf(f, "native,,\"ACSF %u\",%u,0,0,0,%llu,%llu,%llu\n", i, prof.NumRuns,
+			(unsigned long long)prof.TotalTime / 1000, (unsigned long long)prof.MaxTimePerRun / 1000,
+			(unsigned long long)prof.TotalTime / 1000);
+	}
+	fclose(f);
+	Printf("Wrote ACS profile to %s\n", filename);
+}
+
 CCMD(acsprofile)
 {
 	static int (*sort_funcs[])(const void*, const void *) =
@@ -10773,10 +10994,11 @@ CCMD(acsprofile)
 		sort_by_min,
 		sort_by_max,
 		sort_by_avg,
-		sort_by_runs
+		sort_by_runs,
+		sort_by_time
 	};
-	static const char *sort_names[] = { "total", "min", "max", "avg", "runs" };
-	static const uint8_t sort_match_len[] = {   1,     2,     2,     1,      1 };
+	static const char *sort_names[] = { "total", "min", "max", "avg", "runs", "time" };
+	static const uint8_t sort_match_len[] = {   1,     2,     2,     1,      1,     2 };
 
 	TArray<ProfileCollector> ScriptProfiles, FuncProfiles;
 	long limit = 10;
@@ -10794,6 +11016,29 @@ CCMD(acsprofile)
 		{
 			ClearProfiles(ScriptProfiles);
 			ClearProfiles(FuncProfiles);
+			ClearNativeProfiles();
+			return;
+		}
+		// `acsprofile start` and `acsprofile stop` turn time measurement on and off.
+		if (stricmp(argv[1], "start") == 0)
+		{
+			if (NativeProfiles.Size() == 0)
+			{
+				NativeProfiles.Resize(ACSF_SetTeamScore + 1);
+			}
+			ACSTiming = true;
+			return;
+		}
+		if (stricmp(argv[1], "stop") == 0)
+		{
+			ACSTiming = false;
+			return;
+		}
+		// `acsprofile dump <file>` writes all profiling information to a CSV file.
+		if (stricmp(argv[1], "dump") == 0)
+		{
+			if (argv.argc() > 2) DumpProfileData(argv[2], ScriptProfiles, FuncProfiles);
+			else Printf("acsprofile dump <filename>\n");
 			return;
 		}
 		for (int i = 1; i < argv.argc(); ++i)
@@ -10826,7 +11071,9 @@ CCMD(acsprofile)
 			{
 				Printf("Unknown option '%s'\n", argv[i]);
 				Printf("acsprofile clear : Reset profiling information\n");
-				Printf("acsprofile [total|min|max|avg|runs] [<limit>]\n");
+				Printf("acsprofile start|stop : Turn time measurement on or off\n");
+				Printf("acsprofile dump <filename> : Write profiling information to a CSV file\n");
+				Printf("acsprofile [total|min|max|avg|runs|time] [<limit>]\n");
 				return;
 			}
 		}
@@ -10834,6 +11081,7 @@ CCMD(acsprofile)
 
 	ShowProfileData(ScriptProfiles, limit, sorter, false);
 	ShowProfileData(FuncProfiles, limit, sorter, true);
+	ShowNativeProfiles(limit);
 }
 
 ADD_STAT(ACS)
@@ -59,7 +59,76 @@ struct InitIntToZero
 		v = 0;
 	}
 };
-typedef TMap<int32_t, int32_t, THashTraits<int32_t>, InitIntToZero> FWorldGlobalArray;
+
+// World and global arrays. Most scripts use them as plain arrays indexed
+// from 0, so small non-negative indices are stored in chunks that are
+// allocated on first access. Everything else goes into a hash map.
+class FWorldGlobalArray
+{
+public:
+	enum
+	{
+		CHUNK_SHIFT = 8,
+		CHUNK_SIZE = 1 << CHUNK_SHIFT,
+		DENSE_LIMIT = 1 << 20
+	};
+
+	FWorldGlobalArray() = default;
+	FWorldGlobalArray(const FWorldGlobalArray &) = delete;
+	FWorldGlobalArray &operator=(const FWorldGlobalArray &) = delete;
+	~FWorldGlobalArray()
+	{
+		Clear();
+	}
+
+	int32_t &operator[](int32_t index)
+	{
+		if ((uint32_t)index < DENSE_LIMIT)
+		{
+			unsigned chunk = (uint32_t)index >> CHUNK_SHIFT;
+			if (chunk >= Chunks.Size() || Chunks[chunk] == nullptr)
+			{
+				AllocChunk(chunk);
+			}
+			return Chunks[chunk][index & (CHUNK_SIZE - 1)];
+		}
+		return Sparse[index];
+	}
+
+	void Insert(int32_t index, int32_t value)
+	{
+		(*this)[index] = value;
+	}
+
+	// Calls func(index, value) for every element that may be set. Dense
+	// elements that are 0 are skipped, since reading them yields the same.
+	template<class Func> void ForEach(Func func) const
+	{
+		for (unsigned chunk = 0; chunk < Chunks.Size(); chunk++)
+		{
+			if (Chunks[chunk] == nullptr) continue;
+			for (int i = 0; i < CHUNK_SIZE; i++)
+			{
+				if (Chunks[chunk][i] != 0) func(int32_t((chunk << CHUNK_SHIFT) + i), Chunks[chunk][i]);
+			}
+		}
+		TMap<int32_t, int32_t, THashTraits<int32_t>, InitIntToZero>::ConstIterator it(Sparse);
+		TMap<int32_t, int32_t, THashTraits<int32_t>, InitIntToZero>::ConstPair *pair;
+		while (it.NextPair(pair))
+		{
+			func(pair->Key, pair->Value);
+		}
+	}
+
+	unsigned CountUsed() const;
+	void Clear();
+
+private:
+	void AllocChunk(unsigned chunk);
+
+	TArray<int32_t *> Chunks;
+	TMap<int32_t, int32_t, THashTraits<int32_t>, InitIntToZero> Sparse;
+};
 
 // Type of elements count is unsigned int instead of size_t to match ACSStringPool interface
 template <typename T, unsigned int N>
@@ -154,9 +223,12 @@ struct ACSProfileInfo
 	unsigned int NumRuns;
 	unsigned int MinInstrPerRun;
 	unsigned int MaxInstrPerRun;
+	uint64_t TotalTime;		// in ns, including called functions and natives
+	uint64_t MaxTimePerRun;
+	uint64_t NativeTime;	// in ns, spent in ACSF_ functions
 
 	ACSProfileInfo();
-	void AddRun(unsigned int num_instr);
+	void AddRun(unsigned int num_instr, uint64_t time = 0, uint64_t nativetime = 0);
 	void Reset();
 };
 
@@ -48,6 +48,8 @@
 #include "g_levellocals.h"
 #include "vm.h"
 
+#include <algorithm>
+
 CVAR (Int, cl_rockettrails, 1, CVAR_ARCHIVE);
 CVAR (Bool, r_rail_smartspiral, 0, CVAR_ARCHIVE);
 CVAR (Int, r_rail_spiralsparsity, 1, CVAR_ARCHIVE);
@@ -62,7 +64,7 @@ FRandom pr_railtrail("RailTrail");
 uint32_t			ActiveParticles;
 uint32_t			InactiveParticles;
 TArray<particle_t>	Particles;
-TArray<uint16_t>	ParticlesInSubsec;
+TArray<uint32_t>	ParticlesInSubsec;
 
 static int grey1, grey2, grey3, grey4, red, green, blue, yellow, black,
 		   red1, green1, blue1, yellow1, purple, purple1, white,
@@ -126,8 +128,8 @@ CUSTOM_CVAR( Int, r_maxparticles, 4000, CVAR_ARCHIVE )
 {
 	if ( self == 0 )
 		self = 4000;
-	else if (self > 65535)
-		self = 65535;
+	else if (self > MAX_PARTICLES)
+		self = MAX_PARTICLES;
 	else if (self < 100)
 		self = 100;
 
@@ -149,7 +151,7 @@ void P_InitParticles ()
 		num = r_maxparticles;
 
 	// This should be good, but eh...
-	int NumParticles = clamp<int>(num, 100, 65535);
+	int NumParticles = clamp<int>(num, 100, MAX_PARTICLES);
 
 	Particles.Resize(NumParticles);
 	P_ClearParticles ();
@@ -157,7 +159,7 @@ void P_InitParticles ()
 
 void P_ClearParticles ()
 {
-	int i = 0;
+	uint32_t i = 0;
 	memset (Particles.Data(), 0, Particles.Size() * sizeof(particle_t));
 	ActiveParticles = NO_PARTICLE;
 	InactiveParticles = 0;
@@ -177,13 +179,13 @@ void P_FindParticleSubsectors ()
 		ParticlesInSubsec.Reserve (level.subsectors.Size() - ParticlesInSubsec.Size());
 	}
 
-	fillshort (&ParticlesInSubsec[0], level.subsectors.Size(), NO_PARTICLE);
+	std::fill_n(ParticlesInSubsec.Data(), level.subsectors.Size(), NO_PARTICLE);
 
 	if (!r_particles)
 	{
 		return;
 	}
-	for (uint16_t i = ActiveParticles; i != NO_PARTICLE; i = Particles[i].tnext)
+	for (uint32_t i = ActiveParticles; i != NO_PARTICLE; i = Particles[i].tnext)
 	{
 		 // Try to reuse the subsector from the last portal check, if still valid.
 		if (Particles[i].subsector == NULL) Particles[i].subsector = R_PointInSubsector(Particles[i].Pos);
@@ -233,8 +235,9 @@ void P_InitEffects ()
 
 void P_ThinkParticles ()
 {
-	int i;
+	uint32_t i;
 	particle_t *particle, *prev;
+	bool frozen = bglobal.freeze || (level.flags2 & LEVEL2_FROZEN);
 
 	i = ActiveParticles;
 	prev = NULL;
@@ -242,7 +245,7 @@ void P_ThinkParticles ()
 	{
 		particle = &Particles[i];
 		i = particle->tnext;
-		if (!particle->notimefreeze && ((bglobal.freeze) || (level.flags2 & LEVEL2_FROZEN)))
+		if (frozen && !particle->notimefreeze)
 		{
 			prev = particle;
 			continue;
@@ -259,7 +262,7 @@ void P_ThinkParticles ()
 			else
 				ActiveParticles = i;
 			particle->tnext = InactiveParticles;
-			InactiveParticles = (int)(particle - Particles.Data());
+			InactiveParticles = uint32_t(particle - Particles.Data());
 			continue;
 		}
 
@@ -1824,6 +1824,7 @@ bool P_CheckPosition(AActor *thing, const DVector2 &pos, FCheckPosition &tm, boo
 
 	FMultiBlockLinesIterator it(pcheck, pos.X, pos.Y, thing->Z(), thing->Height, thing->radius, newsec);
 	FMultiBlockLinesIterator::CheckResult lcres;
+	it.FilterRange();	// PIT_CheckLine ignores these lines anyway.
 
 	double thingdropoffz = tm.floorz;
 	//bool onthing = (thingdropoffz != tmdropoffz);
@@ -78,6 +78,8 @@
 
 // State.
 #include "po_man.h"
+#include "c_dispatch.h"
+#include "stats.h"
 #include "vm.h"
 
 sector_t *P_PointInSectorBuggy(double x, double y);
@@ -688,6 +690,12 @@ line_t *FBlockLinesIterator::Next()
 				if (ld->validcount != validcount)
 				{
 					ld->validcount = validcount;
+					// Portal lines must always be returned because some callers
+					// process them even if they are outside the box.
+					if (rangeFilter != nullptr && !rangeFilter->inRangeSSE(ld) && ld->getPortal() == nullptr)
+					{
+						continue;
+					}
 					return ld;
 				}
 			}
@@ -702,6 +710,47 @@ line_t *FBlockLinesIterator::Next()
 	}
 }
 
+//===========================================================================
+//
+// CCMD benchlinerange
+//
+// Compares the scalar and the SSE line bounding box checks against each
+// other by testing a box around every vertex against every line of the
+// current level.
+//
+//===========================================================================
+
+CCMD(benchlinerange)
+{
+	if (gamestate != GS_LEVEL || level.lines.Size() == 0)
+	{
+		return;
+	}
+	double radius = argv.argc() > 1 ? atof(argv[1]) : 32;
+	cycle_t scalar, sse;
+	int hits[2] = { 0, 0 };
+	int mismatches = 0;
+
+	scalar.Reset();
+	sse.Reset();
+	for (auto &v : level.vertexes)
+	{
+		FBoundingBox box(v.fX(), v.fY(), radius);
+
+		scalar.Clock();
+		for (auto &ld : level.lines) hits[0] += box.inRange(&ld);
+		scalar.Unclock();
+
+		sse.Clock();
+		for (auto &ld : level.lines) hits[1] += box.inRangeSSE(&ld);
+		sse.Unclock();
+
+		for (auto &ld : level.lines) mismatches += box.inRange(&ld) != box.inRangeSSE(&ld);
+	}
+	Printf("%u boxes x %u lines: scalar %.3f ms, SSE %.3f ms, %d/%d hits, %d mismatches\n",
+		level.vertexes.Size(), level.lines.Size(), scalar.TimeMS(), sse.TimeMS(), hits[0], hits[1], mismatches);
+}
+
 //===========================================================================
 //
 // FMultiBlockLinesIterator :: FMultiBlockLinesIterator
@@ -976,6 +1025,11 @@ AActor *FBlockThingsIterator::Next(bool centeronly)
 			int i;
 
 			block = block->NextActor;
+#ifdef __GNUC__
+			// The caller is going to look at this actor's position and flags
+			// now, so start fetching the next one's while that happens.
+			if (block != NULL) __builtin_prefetch(&block->Me->__Pos);
+#endif
 			// Don't recheck things that were already checked
 			if (mynode->NextBlock == NULL && mynode->PrevBlock == &me->BlockNode)
 			{ // This actor doesn't span blocks, so we know it can only ever be checked once.
@@ -213,6 +213,7 @@ class FBlockLinesIterator
 	polyblock_t *polyLink;
 	int polyIndex;
 	int *list;
+	const FBoundingBox *rangeFilter = nullptr;	// if set, skip blockmap lines outside this box
 
 	void StartBlock(int x, int y);
 
@@ -258,6 +259,12 @@ public:
 
 	bool Next(CheckResult *item);
 	void Reset();
+	// Skips lines whose bounding box does not touch Box() before they are returned.
+	// Only for callers that would reject those lines with FBoundingBox::inRange anyway.
+	void FilterRange()
+	{
+		blockIterator.rangeFilter = &bbox;
+	}
 	// for stopping group traversal through portals. Only the calling code can decide whether this is needed so this needs to be set from the outside.
 	void StopUp()
 	{
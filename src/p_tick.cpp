@@ -37,6 +37,7 @@
 #include "g_levellocals.h"
 #include "events.h"
 #include "actorinlines.h"
+#include "c_dispatch.h"
 
 extern gamestate_t wipegamestate;
 
@@ -153,3 +154,113 @@ void P_Ticker (void)
 	level.maptime++;
 	level.totaltime++;
 }
+
+#ifdef _DEBUG
+//==========================================================================
+//
+// CCMD actorislands
+//
+// Partitions the level's actors into islands that cannot affect each
+// other within one tic: actors sharing or bordering a blockmap cell
+// (portal links included, since they are stored in the same cells) and
+// actors referencing each other through target, tracer or master end
+// up in the same island. The result tells how far ticking could scale
+// if islands were run concurrently. This is an analysis tool for
+// developers, so it is only built into debug builds.
+//
+//==========================================================================
+
+static int FindIsland(TArray<int> &parent, int i)
+{
+	while (parent[i] != i)
+	{
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+	return i;
+}
+
+static void UniteIslands(TArray<int> &parent, int a, int b)
+{
+	a = FindIsland(parent, a);
+	b = FindIsland(parent, b);
+	if (a != b) parent[MAX(a, b)] = MIN(a, b);
+}
+
+CCMD(actorislands)
+{
+	if (gamestate != GS_LEVEL || level.blockmap.blocklinks == nullptr)
+	{
+		return;
+	}
+
+	TMap<AActor *, int> index;
+	TArray<int> parent;
+	TThinkerIterator<AActor> it;
+	AActor *ac;
+
+	while ((ac = it.Next()))
+	{
+		index[ac] = parent.Push(parent.Size());
+	}
+	if (parent.Size() == 0)
+	{
+		return;
+	}
+
+	auto &bmap = level.blockmap;
+	TArray<int> cellrep(bmap.bmapwidth * bmap.bmapheight, true);
+	for (int y = 0; y < bmap.bmapheight; y++)
+	{
+		for (int x = 0; x < bmap.bmapwidth; x++)
+		{
+			int cell = y * bmap.bmapwidth + x;
+			cellrep[cell] = -1;
+			for (FBlockNode *node = bmap.blocklinks[cell]; node != nullptr; node = node->NextActor)
+			{
+				int *i = index.CheckKey(node->Me);
+				if (i == nullptr) continue;
+				if (cellrep[cell] < 0) cellrep[cell] = *i;
+				else UniteIslands(parent, cellrep[cell], *i);
+			}
+			if (cellrep[cell] < 0) continue;
+
+			// Merge with the already processed neighbours so that actors close
+			// to a cell boundary are not treated as independent.
+			static const int offsets[][2] = { { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 } };
+			for (auto &o : offsets)
+			{
+				int nx = x + o[0], ny = y + o[1];
+				if (bmap.isValidBlock(nx, ny) && cellrep[ny * bmap.bmapwidth + nx] >= 0)
+				{
+					UniteIslands(parent, cellrep[cell], cellrep[ny * bmap.bmapwidth + nx]);
+				}
+			}
+		}
+	}
+
+	it.Reinit();
+	while ((ac = it.Next()))
+	{
+		int self = index[ac];
+		AActor *links[] = { ac->target, ac->tracer, ac->master };
+		for (auto link : links)
+		{
+			int *i = link != nullptr ? index.CheckKey(link) : nullptr;
+			if (i != nullptr) UniteIslands(parent, self, *i);
+		}
+	}
+
+	TArray<int> sizes(parent.Size(), true);
+	memset(sizes.Data(), 0, sizes.Size() * sizeof(int));
+	int islands = 0, largest = 0;
+	for (unsigned i = 0; i < parent.Size(); i++)
+	{
+		int &size = sizes[FindIsland(parent, i)];
+		if (size++ == 0) islands++;
+		largest = MAX(largest, size);
+	}
+	Printf("%u actors in %d islands, largest has %d actors (%.1f%%), speedup bound %.2fx\n",
+		parent.Size(), islands, largest, largest * 100. / parent.Size(), double(parent.Size()) / largest);
+}
+#endif
@@ -35,6 +35,10 @@
 #include "m_bbox.h"
 #include "dobjgc.h"
 
+#ifndef NO_SSE
+#include <emmintrin.h>
+#endif
+
 // Some more or less basic data types
 // we depend on.
 #include "m_fixed.h"
@@ -1616,6 +1620,26 @@ inline bool FBoundingBox::inRange(const line_t *ld) const
 		Bottom() < ld->bbox[BOXTOP];
 }
 
+// Same as inRange but does all four comparisons at once. The comparisons
+// are the same, so the result is identical, including for NaNs.
+inline bool FBoundingBox::inRangeSSE(const line_t *ld) const
+{
+#ifndef NO_SSE
+	static_assert(BOXTOP == 0 && BOXBOTTOM == 1 && BOXLEFT == 2 && BOXRIGHT == 3, "bounding box layout changed");
+	__m128d tb = _mm_loadu_pd(&ld->bbox[BOXTOP]);			// ld top, ld bottom
+	__m128d lr = _mm_loadu_pd(&ld->bbox[BOXLEFT]);			// ld left, ld right
+	__m128d mytb = _mm_loadu_pd(&m_Box[BOXTOP]);			// top, bottom
+	__m128d mylr = _mm_loadu_pd(&m_Box[BOXLEFT]);			// left, right
+	// bottom < ld top, ld bottom < top
+	__m128d v = _mm_cmplt_pd(_mm_shuffle_pd(mytb, tb, 3), _mm_shuffle_pd(tb, mytb, 0));
+	// left < ld right, ld left < right
+	__m128d h = _mm_cmplt_pd(_mm_shuffle_pd(mylr, lr, 0), _mm_shuffle_pd(lr, mylr, 3));
+	return _mm_movemask_pd(_mm_and_pd(v, h)) == 3;
+#else
+	return inRange(ld);
+#endif
+}
+
 
 inline void FColormap::CopyFrom3DLight(lightlist_t *light)
 {
@@ -104,15 +104,37 @@ struct CZDFileInStream
 	}
 };
 
+//-----------------------------------------------------------------------
+//
+// In solid archives many files share one compressed block, which always
+// has to be decompressed from its start. To avoid doing that for every
+// file, the most recently used decompressed blocks are kept around, up
+// to BLOCK_CACHE_SIZE bytes for all open archives together. The last one
+// used is always kept, even if it is larger than that.
+//
+//-----------------------------------------------------------------------
+
 struct C7zArchive
 {
+	enum { BLOCK_CACHE_SIZE = 64 << 20 };
+
+	struct CachedBlock
+	{
+		UInt32 Index;
+		Byte *Buffer;
+		size_t Size;
+		unsigned LastUse;
+	};
+
 	CSzArEx DB;
 	CZDFileInStream ArchiveStream;
 	CLookToRead2 LookStream;
 	Byte StreamBuffer[1<<14];
-	UInt32 BlockIndex;
-	Byte *OutBuffer;
-	size_t OutBufferSize;
+	TArray<CachedBlock> Blocks;
+
+	static TArray<C7zArchive *> AllArchives;
+	static size_t CachedSize;
+	static unsigned UseCount;
 
 	C7zArchive(FileReader &file) : ArchiveStream(file)
 	{
@@ -127,17 +149,17 @@ struct C7zArchive
 		LookStream.bufSize = sizeof(StreamBuffer);
 		LookStream.buf = StreamBuffer;
 		SzArEx_Init(&DB);
-		BlockIndex = 0xFFFFFFFF;
-		OutBuffer = NULL;
-		OutBufferSize = 0;
+		AllArchives.Push(this);
 	}
 
 	~C7zArchive()
 	{
-		if (OutBuffer != NULL)
+		for (auto &block : Blocks)
 		{
-			IAlloc_Free(&g_Alloc, OutBuffer);
+			CachedSize -= block.Size;
+			IAlloc_Free(&g_Alloc, block.Buffer);
 		}
+		AllArchives.Delete(AllArchives.Find(this));
 		SzArEx_Free(&DB, &g_Alloc);
 	}
 
@@ -148,18 +170,84 @@ struct C7zArchive
 
 	SRes Extract(UInt32 file_index, char *buffer)
 	{
+		UInt32 folder = DB.FileToFolder[file_index];
+		if (folder == (UInt32)-1)
+		{
+			return SZ_OK;	// empty file, nothing to decompress.
+		}
+
+		unsigned i;
+		for (i = 0; i < Blocks.Size(); i++)
+		{
+			if (Blocks[i].Index == folder) break;
+		}
+		bool cached = i < Blocks.Size();
+		if (!cached)
+		{
+			CachedBlock block = { 0xFFFFFFFF, NULL, 0, 0 };
+			i = Blocks.Push(block);
+		}
+
+		// With a matching block index this only locates and checks the file inside the block.
+		auto &block = Blocks[i];
 		size_t offset, out_size_processed;
 		SRes res = SzArEx_Extract(&DB, &LookStream.vt, file_index,
-			&BlockIndex, &OutBuffer, &OutBufferSize,
+			&block.Index, &block.Buffer, &block.Size,
 			&offset, &out_size_processed,
 			&g_Alloc, &g_Alloc);
 		if (res == SZ_OK)
 		{
-			memcpy(buffer, OutBuffer + offset, out_size_processed);
+			memcpy(buffer, block.Buffer + offset, out_size_processed);
+		}
+		block.LastUse = ++UseCount;
+		if (!cached)
+		{
+			if (res != SZ_OK)
+			{
+				// The block may not have been fully decompressed.
+				IAlloc_Free(&g_Alloc, block.Buffer);
+				Blocks.Delete(i);
+				return res;
+			}
+			CachedSize += block.Size;
+			TrimCache();
 		}
 		return res;
 	}
+
+	// Frees the least recently used blocks of all archives until the cache
+	// fits into BLOCK_CACHE_SIZE again.
+	static void TrimCache()
+	{
+		while (CachedSize > BLOCK_CACHE_SIZE)
+		{
+			C7zArchive *oldarc = nullptr;
+			unsigned oldest = 0;
+			for (auto arc : AllArchives)
+			{
+				for (unsigned i = 0; i < arc->Blocks.Size(); i++)
+				{
+					// Never free the block that was just used.
+					if (arc->Blocks[i].LastUse == UseCount) continue;
+					if (oldarc == nullptr || arc->Blocks[i].LastUse < oldarc->Blocks[oldest].LastUse)
+					{
+						oldarc = arc;
+						oldest = i;
+					}
+				}
+			}
+			if (oldarc == nullptr) break;
+			CachedSize -= oldarc->Blocks[oldest].Size;
+			IAlloc_Free(&g_Alloc, oldarc->Blocks[oldest].Buffer);
+			oldarc->Blocks.Delete(oldest);
+		}
+	}
 };
+
+TArray<C7zArchive *> C7zArchive::AllArchives;
+size_t C7zArchive::CachedSize;
+unsigned C7zArchive::UseCount;
+
 //==========================================================================
 //
 // Zip Lump
@@ -38,6 +38,8 @@
 #include "resourcefile.h"
 #include "cmdlib.h"
 #include "w_wad.h"
+#include "c_cvars.h"
+#include "c_dispatch.h"
 #include "gi.h"
 #include "doomstat.h"
 
@@ -75,6 +77,7 @@ public:
 
 FResourceLump::~FResourceLump()
 {
+	UnlinkCache();
 	if (Cache != NULL && RefCount >= 0)
 	{
 		delete [] Cache;
@@ -242,33 +245,118 @@ void *FResourceLump::CacheLump()
 	if (Cache != NULL)
 	{
 		if (RefCount > 0) RefCount++;
+		else if (IsCacheLinked())
+		{
+			// The data was released but kept around, so it can be reused.
+			UnlinkCache();
+			RefCount = 1;
+			if (Owner != NULL) Owner->CacheHits++;
+		}
 	}
 	else if (LumpSize > 0)
 	{
 		FillCache();
+		if (Owner != NULL) Owner->CacheMisses++;
 	}
 	return Cache;
 }
 
 //==========================================================================
 //
-// Decrements reference counter and frees lump if counter reaches 0
+// Decrements reference counter. When it reaches 0, the data is kept in
+// the list of released caches as long as they stay within the budget
+// set by lump_cachesize, and deleted otherwise. The budget is 0 by
+// default, so released data is freed right away unless asked otherwise.
 //
 //==========================================================================
 
+CUSTOM_CVAR(Int, lump_cachesize, 0, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	if (self < 0) self = 0;
+	else FResourceLump::TrimCache((size_t)self << 20);
+}
+
 int FResourceLump::ReleaseCache()
 {
 	if (LumpSize > 0 && RefCount > 0)
 	{
 		if (--RefCount == 0)
 		{
-			delete [] Cache;
-			Cache = NULL;
+			size_t budget = (size_t)*lump_cachesize << 20;
+			if ((size_t)LumpSize <= budget)
+			{
+				LinkCache();
+				TrimCache(budget);
+			}
+			else
+			{
+				delete [] Cache;
+				Cache = NULL;
+			}
 		}
 	}
 	return RefCount;
 }
 
+//==========================================================================
+//
+// List of released lump caches, most recently released first
+//
+//==========================================================================
+
+static FResourceLump *CacheHead, *CacheTail;
+static size_t CacheSize;
+
+bool FResourceLump::IsCacheLinked() const
+{
+	return CachePrev != NULL || CacheHead == this;
+}
+
+void FResourceLump::LinkCache()
+{
+	CachePrev = NULL;
+	CacheNext = CacheHead;
+	if (CacheHead != NULL) CacheHead->CachePrev = this;
+	else CacheTail = this;
+	CacheHead = this;
+	CacheSize += LumpSize;
+}
+
+void FResourceLump::UnlinkCache()
+{
+	if (!IsCacheLinked()) return;
+	if (CachePrev != NULL) CachePrev->CacheNext = CacheNext;
+	else CacheHead = CacheNext;
+	if (CacheNext != NULL) CacheNext->CachePrev = CachePrev;
+	else CacheTail = CachePrev;
+	CachePrev = CacheNext = NULL;
+	CacheSize -= LumpSize;
+}
+
+//==========================================================================
+//
+// Deletes the least recently released caches until the rest fits into
+// the budget.
+//
+//==========================================================================
+
+void FResourceLump::TrimCache(size_t budget)
+{
+	while (CacheSize > budget && CacheTail != NULL)
+	{
+		FResourceLump *lump = CacheTail;
+		lump->UnlinkCache();
+		if (lump->Owner != NULL) lump->Owner->EvictedBytes += lump->LumpSize;
+		delete [] lump->Cache;
+		lump->Cache = NULL;
+	}
+}
+
+size_t FResourceLump::CachedBytes()
+{
+	return CacheSize;
+}
+
 //==========================================================================
 //
 // Opens a resource file
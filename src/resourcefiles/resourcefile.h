@@ -49,6 +49,8 @@ struct FResourceLump
 	FResourceFile *	Owner;
 	FTexture *		LinkedTexture;
 	int				Namespace;
+	FResourceLump *	CachePrev;		// links in the list of released caches that are kept around
+	FResourceLump *	CacheNext;
 
 	FResourceLump()
 	{
@@ -59,6 +61,7 @@ struct FResourceLump
 		Namespace = 0;	// ns_global
 		*Name = 0;
 		LinkedTexture = NULL;
+		CachePrev = CacheNext = NULL;
 	}
 
 	virtual ~FResourceLump();
@@ -72,10 +75,16 @@ struct FResourceLump
 
 	void *CacheLump();
 	int ReleaseCache();
+	static void TrimCache(size_t budget);
+	static size_t CachedBytes();
 
 protected:
 	virtual int FillCache() = 0;
 
+private:
+	bool IsCacheLinked() const;
+	void LinkCache();
+	void UnlinkCache();
 };
 
 class FResourceFile
@@ -83,6 +92,11 @@ class FResourceFile
 public:
 	FileReader Reader;
 	FString FileName;
+
+	// Lump cache statistics. A hit is a released cache that got reused.
+	unsigned CacheHits = 0;
+	unsigned CacheMisses = 0;
+	uint64_t EvictedBytes = 0;
 protected:
 	uint32_t NumLumps;
 
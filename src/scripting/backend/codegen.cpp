@@ -8970,6 +8970,41 @@ FxExpression *FxVMFunctionCall::Resolve(FCompileContext& ctx)
 	return this;
 }
 
+//==========================================================================
+//
+// IsNeverOverridden
+//
+// Checks if no class derived from cls replaces the given virtual function,
+// so that calling it through an object of that type can skip the virtual
+// table. All classes are known once code gets generated. The only ones
+// created afterward are Dehacked's, which just copy their parent's table.
+//
+//==========================================================================
+
+static TMap<uint64_t, bool> NeverOverridden;
+
+void ResetDevirtualization()
+{
+	NeverOverridden.Clear();
+}
+
+static bool IsNeverOverridden(PClass *cls, VMFunction *func)
+{
+	uint64_t key = (uint64_t)(uintptr_t)cls * 4096 + func->VirtualIndex;
+
+	bool *result = NeverOverridden.CheckKey(key);
+	if (result != nullptr) return *result;
+
+	bool never = func->VirtualIndex < cls->Virtuals.Size() && cls->Virtuals[func->VirtualIndex] == func;
+	for (unsigned i = 0; i < PClass::AllClasses.Size() && never; i++)
+	{
+		auto c = PClass::AllClasses[i];
+		never = !c->IsDescendantOf(cls) || func->VirtualIndex >= c->Virtuals.Size() || c->Virtuals[func->VirtualIndex] == func;
+	}
+	NeverOverridden[key] = never;
+	return never;
+}
+
 //==========================================================================
 //
 //
@@ -8995,6 +9030,17 @@ ExpEmit FxVMFunctionCall::Emit(VMFunctionBuilder *build)
 	VMFunction *vmfunc = Function->Variants[0].Implementation;
 	bool staticcall = ((vmfunc->VarFlags & VARF_Final) || vmfunc->VirtualIndex == ~0u || NoVirtual);
 
+	// Devirtualize calls on self to functions that no subclass overrides. Other
+	// receivers still need the VTBL instruction's null check.
+	if (!staticcall && Self != nullptr && Self->ExprType == EFX_Self && Self->ValueType->isObjectPointer())
+	{
+		auto clstype = PType::toClass(Self->ValueType->toPointer()->PointedType);
+		if (clstype != nullptr && IsNeverOverridden(clstype->Descriptor, vmfunc))
+		{
+			staticcall = true;
+		}
+	}
+
 	count = 0;
 	FunctionCallEmitter emitters(vmfunc);
 	// Emit code to pass implied parameters
@@ -62,6 +62,9 @@ class FxJumpStatement;
 
 extern FMemArena FxAlloc;
 
+// Forgets which virtual functions were found to be never overridden.
+void ResetDevirtualization();
+
 //==========================================================================
 //
 //
@@ -107,8 +107,43 @@ void VMFunctionBuilder::EndStatement()
 	}
 }
 
+//==========================================================================
+//
+// VMFunctionBuilder :: ThreadJumps
+//
+// Nested loops and if/else chains tend to produce jumps that land on
+// another jump. Point each of them at the final target instead. This does
+// not add or remove instructions, so line numbers stay valid. Can be
+// turned off with -noscriptopt to compare -dumpdisasm output.
+//
+//==========================================================================
+
+void VMFunctionBuilder::ThreadJumps()
+{
+	static int enabled = -1;
+	if (enabled < 0) enabled = !Args->CheckParm("-noscriptopt");
+	if (!enabled) return;
+
+	for (unsigned i = 0; i < Code.Size(); i++)
+	{
+		if (Code[i].op != OP_JMP) continue;
+
+		size_t target = i + 1 + Code[i].i24;
+		// Limit the number of hops so that jump cycles (empty endless loops) terminate.
+		for (int hops = 0; hops < 16 && target < Code.Size() && Code[target].op == OP_JMP && target != i; hops++)
+		{
+			target = target + 1 + Code[target].i24;
+		}
+		if (target != i && target <= Code.Size())
+		{
+			Backpatch(i, target);
+		}
+	}
+}
+
 void VMFunctionBuilder::MakeFunction(VMScriptFunction *func)
 {
+	ThreadJumps();
 	func->Alloc(Code.Size(), IntConstantList.Size(), FloatConstantList.Size(), StringConstantList.Size(), AddressConstantList.Size(), LineNumbers.Size());
 
 	// Copy code block.
@@ -802,6 +837,20 @@ VMFunction *FFunctionBuildList::AddFunction(PNamespace *gnspc, const VersionInfo
 	return it.Function;
 }
 
+//==========================================================================
+//
+// FFunctionBuildList :: Build
+//
+// Resolves and emits all function bodies, in the order they were added.
+//
+// This has to stay on a single thread: expression nodes are allocated
+// from the shared FxAlloc arena, FString reference counts are not atomic,
+// and resolving an expression may create new types, names and symbols in
+// global tables (TypeTable, the FName table, ClassDataAllocator for the
+// finished function). Moving function bodies to worker threads would
+// require all of those to be made thread safe first.
+//
+//==========================================================================
 
 void FFunctionBuildList::Build()
 {
@@ -811,6 +860,9 @@ void FFunctionBuildList::Build()
 
 	if (Args->CheckParm("-dumpdisasm")) dump = fopen("disasm.txt", "w");
 
+	// The class pointers from a previous run of the compiler may have been reused.
+	ResetDevirtualization();
+
 	for (auto &item : mItems)
 	{
 		assert(item.Code != NULL);
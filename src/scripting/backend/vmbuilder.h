@@ -98,6 +98,8 @@ public:
 	TArray<FxLocalVariableDeclaration *> ConstructedStructs;
 
 private:
+	void ThreadJumps();
+
 	TArray<FStatementInfo> LineNumbers;
 	TArray<FxExpression *> StatementStack;
 
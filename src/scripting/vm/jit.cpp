@@ -291,6 +291,8 @@ void JitCompiler::SetupSimpleFrame()
 	using namespace asmjit;
 
 	// This is a simple frame with no constructors or destructors. Allocate it on the stack ourselves.
+	// Full frames are counted by VMFrameStack::AllocFrame, so only these need to be counted here.
+	IncrementVMFrameAllocs();
 
 	vmframeCursor = cc.getCursor();
 
@@ -407,6 +409,17 @@ void JitCompiler::IncrementVMCalls()
 	cc.mov(asmjit::x86::dword_ptr(vmcallsptr), vmcalls);
 }
 
+void JitCompiler::IncrementVMFrameAllocs()
+{
+	// VMFrameAllocs[0]++
+	auto allocsptr = newTempIntPtr();
+	auto allocs = newTempInt32();
+	cc.mov(allocsptr, asmjit::imm_ptr(VMFrameAllocs));
+	cc.mov(allocs, asmjit::x86::dword_ptr(allocsptr));
+	cc.add(allocs, (int)1);
+	cc.mov(asmjit::x86::dword_ptr(allocsptr), allocs);
+}
+
 void JitCompiler::CreateRegisters()
 {
 	regD.Resize(sfunc->NumRegD);
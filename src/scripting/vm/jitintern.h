@@ -15,6 +15,7 @@
 
 extern cycle_t VMCycles[10];
 extern int VMCalls[10];
+extern int VMFrameAllocs[10];
 
 #define A				(pc[0].a)
 #define B				(pc[0].b)
@@ -53,6 +54,7 @@ private:
 	void Setup();
 	void CreateRegisters();
 	void IncrementVMCalls();
+	void IncrementVMFrameAllocs();
 	void SetupFrame();
 	void SetupSimpleFrame();
 	void SetupFullVMFrame();
@@ -58,8 +58,15 @@ CUSTOM_CVAR(Bool, vm_jit, true, CVAR_NOINITCALL)
 CVAR(Bool, vm_jit, false, CVAR_NOINITCALL|CVAR_NOSET)
 #endif
 
+// Number of calls a function runs in the interpreter before it gets compiled.
+// Most functions that are only called during startup or level setup never get
+// this far, so they do not cost any compile time.
+CVAR(Int, vm_jit_threshold, 2, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+
 cycle_t VMCycles[10];
 int VMCalls[10];
+int VMFrameAllocs[10];
+static int VMFrameBlocks, VMFrameBlockBytes;
 
 #if 0
 IMPLEMENT_CLASS(VMException, false, false)
@@ -285,9 +292,7 @@ int VMScriptFunction::FirstScriptCall(VMFunction *func, VMValue *params, int num
 #ifdef ARCH_X64
 	if (vm_jit && CanJit(static_cast<VMScriptFunction*>(func)))
 	{
-		func->ScriptCall = JitCompile(static_cast<VMScriptFunction*>(func));
-		if (!func->ScriptCall)
-			func->ScriptCall = VMExec;
+		func->ScriptCall = vm_jit_threshold > 1 ? &VMScriptFunction::ColdScriptCall : &VMScriptFunction::JitScriptCall;
 	}
 	else
 	{
@@ -300,6 +305,30 @@ int VMScriptFunction::FirstScriptCall(VMFunction *func, VMValue *params, int num
 	return func->ScriptCall(func, params, numparams, ret, numret);
 }
 
+// Runs the function in the interpreter until it has been called often enough to be worth compiling.
+int VMScriptFunction::ColdScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret)
+{
+	auto sfunc = static_cast<VMScriptFunction*>(func);
+	if (++sfunc->CallCount >= vm_jit_threshold)
+	{
+		return JitScriptCall(func, params, numparams, ret, numret);
+	}
+	return VMExec(func, params, numparams, ret, numret);
+}
+
+int VMScriptFunction::JitScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret)
+{
+#ifdef ARCH_X64
+	func->ScriptCall = JitCompile(static_cast<VMScriptFunction*>(func));
+	if (!func->ScriptCall)
+		func->ScriptCall = VMExec;
+#else
+	func->ScriptCall = VMExec;
+#endif
+
+	return func->ScriptCall(func, params, numparams, ret, numret);
+}
+
 int VMNativeFunction::NativeScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *returns, int numret)
 {
 	try
@@ -363,6 +392,8 @@ VMFrameStack::~VMFrameStack()
 		for (block = Blocks; block != NULL; block = next)
 		{
 			next = block->NextBlock;
+			VMFrameBlocks--;
+			VMFrameBlockBytes -= block->BlockSize;
 			delete[] (VM_UBYTE *)block;
 		}
 		Blocks = NULL;
@@ -373,6 +404,8 @@ VMFrameStack::~VMFrameStack()
 		for (block = UnusedBlocks; block != NULL; block = next)
 		{
 			next = block->NextBlock;
+			VMFrameBlocks--;
+			VMFrameBlockBytes -= block->BlockSize;
 			delete[] (VM_UBYTE *)block;
 		}
 		UnusedBlocks = NULL;
@@ -390,15 +423,18 @@ VMFrameStack::~VMFrameStack()
 
 VMFrame *VMFrameStack::AllocFrame(VMScriptFunction *func)
 {
-	VMFrame *frame = Alloc(func->StackSize);
+	VMFrame *frame = Alloc(func->StackSize, func->MaxParam);
 	frame->Func = func;
 	frame->NumRegD = func->NumRegD;
 	frame->NumRegF = func->NumRegF;
 	frame->NumRegS = func->NumRegS;
 	frame->NumRegA = func->NumRegA;
 	frame->MaxParam = func->MaxParam;
-	frame->Func = func;
-	frame->InitRegS();
+	if (func->NumRegS != 0)
+	{
+		frame->InitRegS();
+	}
+	VMFrameAllocs[0]++;
 	if (func->SpecialInits.Size())
 	{
 		func->InitExtra(frame->GetExtra());
@@ -411,11 +447,13 @@ VMFrame *VMFrameStack::AllocFrame(VMScriptFunction *func)
 // VMFrameStack :: Alloc
 //
 // Allocates space for a frame. Its size will be rounded up to a multiple
-// of 16 bytes.
+// of 16 bytes. Everything but the parameter area is cleared. Parameters
+// are always written before they are read, so the numparam slots after
+// the frame header are left alone.
 //
 //===========================================================================
 
-VMFrame *VMFrameStack::Alloc(int size)
+VMFrame *VMFrameStack::Alloc(int size, int numparam)
 {
 	BlockHeader *block;
 	VMFrame *frame, *parent;
@@ -453,6 +491,8 @@ VMFrame *VMFrameStack::Alloc(int size)
 		{
 			block = (BlockHeader *)new VM_UBYTE[blocksize];
 			block->BlockSize = blocksize;
+			VMFrameBlocks++;
+			VMFrameBlockBytes += blocksize;
 		}
 		block->InitFreeSpace();
 		block->LastFrame = NULL;
@@ -460,7 +500,10 @@ VMFrame *VMFrameStack::Alloc(int size)
 		Blocks = block;
 	}
 	frame = (VMFrame *)block->FreeSpace;
-	memset(frame, 0, size);
+	int headersize = (sizeof(VMFrame) + 15) & ~15;
+	int paramsize = numparam * sizeof(VMValue);
+	memset(frame, 0, headersize);
+	memset((VM_UBYTE *)frame + headersize + paramsize, 0, size - headersize - paramsize);
 	frame->ParentFrame = parent;
 	block->FreeSpace += size;
 	block->LastFrame = frame;
@@ -737,6 +780,20 @@ ADD_STAT(VM)
 	return FStringf("VM time in last 10 tics: %f ms, %d calls, peak = %f ms", added, addedc, peak);
 }
 
+ADD_STAT(VMFrames)
+{
+	int added = 0;
+	int peak = 0;
+	for (auto d : VMFrameAllocs)
+	{
+		added += d;
+		peak = MAX(peak, d);
+	}
+	memmove(&VMFrameAllocs[1], &VMFrameAllocs[0], 9 * sizeof(int));
+	VMFrameAllocs[0] = 0;
+	return FStringf("VM frames in last 10 tics: %d allocated, peak = %d, %d blocks using %d bytes", added, peak, VMFrameBlocks, VMFrameBlockBytes);
+}
+
 //-----------------------------------------------------------------------------
 //
 //
@@ -374,7 +374,7 @@ private:
 	};
 	BlockHeader *Blocks;
 	BlockHeader *UnusedBlocks;
-	VMFrame *Alloc(int size);
+	VMFrame *Alloc(int size, int numparam);
 };
 
 class VMParamFiller
@@ -470,6 +470,8 @@ public:
 	VM_UHALF MaxParam;		// Maximum number of parameters this function has on the stack at once
 	VM_UBYTE NumArgs;		// Number of arguments this function takes
 	TArray<FTypeAndOffset> SpecialInits;	// list of all contents on the extra stack which require construction and destruction
+	int(*ProfiledCall)(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret) = nullptr;	// the real ScriptCall while the profiler is running
+	int CallCount = 0;		// interpreted calls so far, for deciding when to compile it
 
 	void InitExtra(void *addr);
 	void DestroyExtra(void *addr);
@@ -478,4 +480,6 @@ public:
 
 private:
 	static int FirstScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret);
+	static int ColdScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret);
+	static int JitScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret);
 };
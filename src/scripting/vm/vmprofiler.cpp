@@ -0,0 +1,312 @@
+/*
+** vmprofiler.cpp
+** Per-function time profiler for script code
+**
+**---------------------------------------------------------------------------
+** Copyright 2018 GZDoom contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** Both the interpreter and JIT compiled code call script functions through
+** VMFunction::ScriptCall, so while the profiler runs every script function
+** gets ProfileScriptCall installed there. It records the call into a call
+** tree, which is enough to get inclusive and exclusive times per function
+** as well as complete call stacks for flame graphs.
+**
+*/
+
+#include <algorithm>
+#include "dobject.h"
+#include "v_text.h"
+#include "c_dispatch.h"
+#include "templates.h"
+#include "vmintern.h"
+#include "types.h"
+#include "i_time.h"
+
+struct FProfileNode
+{
+	VMScriptFunction *Func;
+	FString Label;
+	int Parent;
+	int FirstChild;
+	int NextSibling;
+	unsigned Calls;
+	uint64_t Inclusive;		// in ns
+	uint64_t Callees;		// in ns, time spent in the children
+};
+
+static TArray<FProfileNode> ProfileNodes;
+static TArray<int> ProfileStack;
+static bool Profiling;
+static uint64_t ProfileStart, ProfileTime;
+
+//==========================================================================
+//
+// GetChildNode
+//
+// Finds or creates the call tree node for calling func from parent.
+//
+//==========================================================================
+
+static int GetChildNode(int parent, VMScriptFunction *func)
+{
+	int prev = -1;
+	for (int c = ProfileNodes[parent].FirstChild; c >= 0; prev = c, c = ProfileNodes[c].NextSibling)
+	{
+		if (ProfileNodes[c].Func == func)
+		{
+			return c;
+		}
+	}
+	FProfileNode node = { func, "", parent, -1, -1, 0, 0, 0 };
+	node.Label.Format("%s (%s:%d)", func->PrintableName.GetChars(), func->SourceFileName.GetChars(), func->PCToLine(func->Code));
+	int index = ProfileNodes.Push(node);
+	if (prev < 0) ProfileNodes[parent].FirstChild = index;
+	else ProfileNodes[prev].NextSibling = index;
+	return index;
+}
+
+//==========================================================================
+//
+// ProfileScriptCall
+//
+//==========================================================================
+
+static void FinishCall(int node, uint64_t start)
+{
+	uint64_t time = I_nsTime() - start;
+	ProfileNodes[node].Calls++;
+	ProfileNodes[node].Inclusive += time;
+	ProfileNodes[ProfileNodes[node].Parent].Callees += time;
+	ProfileStack.Pop();
+}
+
+static int ProfileScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret)
+{
+	auto sfunc = static_cast<VMScriptFunction *>(func);
+	int node = GetChildNode(ProfileStack.Last(), sfunc);
+	int result;
+
+	ProfileStack.Push(node);
+	uint64_t start = I_nsTime();
+	try
+	{
+		result = sfunc->ProfiledCall(func, params, numparams, ret, numret);
+	}
+	catch (...)
+	{
+		FinishCall(node, start);
+		throw;
+	}
+	FinishCall(node, start);
+
+	// The first call replaces ScriptCall with the JIT compiled code or VMExec.
+	// Put the profiler back in front of it.
+	if (func->ScriptCall != ProfileScriptCall)
+	{
+		sfunc->ProfiledCall = func->ScriptCall;
+		func->ScriptCall = ProfileScriptCall;
+	}
+	return result;
+}
+
+//==========================================================================
+//
+// StartProfiler / StopProfiler
+//
+//==========================================================================
+
+static void StartProfiler()
+{
+	FProfileNode root = { nullptr, "", 0, -1, -1, 0, 0, 0 };
+	ProfileNodes.Clear();
+	ProfileNodes.Push(root);
+	ProfileStack.Clear();
+	ProfileStack.Push(0);
+	ProfileTime = 0;
+	ProfileStart = I_nsTime();
+
+	for (auto func : VMFunction::AllFunctions)
+	{
+		if (!(func->VarFlags & VARF_Native) && func->ScriptCall != ProfileScriptCall)
+		{
+			static_cast<VMScriptFunction *>(func)->ProfiledCall = func->ScriptCall;
+			func->ScriptCall = ProfileScriptCall;
+		}
+	}
+	Profiling = true;
+}
+
+static void StopProfiler()
+{
+	for (auto func : VMFunction::AllFunctions)
+	{
+		if (func->ScriptCall == ProfileScriptCall)
+		{
+			func->ScriptCall = static_cast<VMScriptFunction *>(func)->ProfiledCall;
+		}
+	}
+	ProfileTime += I_nsTime() - ProfileStart;
+	Profiling = false;
+}
+
+//==========================================================================
+//
+// PrintProfile
+//
+// Prints the functions with the highest exclusive time. A recursive
+// function's inclusive time is only counted for its outermost call.
+//
+//==========================================================================
+
+struct FFunctionProfile
+{
+	FString Label;
+	unsigned Calls;
+	uint64_t Inclusive, Exclusive;
+};
+
+static void PrintProfile(unsigned count)
+{
+	TMap<VMScriptFunction *, unsigned> index;
+	TArray<FFunctionProfile> funcs;
+
+	for (unsigned i = 1; i < ProfileNodes.Size(); i++)
+	{
+		auto &node = ProfileNodes[i];
+		unsigned *pi = index.CheckKey(node.Func);
+		if (pi == nullptr)
+		{
+			FFunctionProfile f = { node.Label, 0, 0, 0 };
+			index[node.Func] = funcs.Push(f);
+			pi = index.CheckKey(node.Func);
+		}
+		auto &f = funcs[*pi];
+		f.Calls += node.Calls;
+		f.Exclusive += node.Inclusive - node.Callees;
+
+		bool recursive = false;
+		for (int p = node.Parent; p > 0 && !recursive; p = ProfileNodes[p].Parent)
+		{
+			recursive = ProfileNodes[p].Func == node.Func;
+		}
+		if (!recursive) f.Inclusive += node.Inclusive;
+	}
+
+	std::sort(funcs.begin(), funcs.end(), [](const FFunctionProfile &a, const FFunctionProfile &b) { return a.Exclusive > b.Exclusive; });
+
+	double total = (Profiling ? ProfileTime + I_nsTime() - ProfileStart : ProfileTime) / 1e6;
+	Printf("Profiled %.1f ms, %u functions called\n", total, funcs.Size());
+	Printf(TEXTCOLOR_YELLOW "%10s %12s %12s  %s\n", "calls", "excl. ms", "incl. ms", "function");
+	for (unsigned i = 0; i < funcs.Size() && i < count; i++)
+	{
+		Printf("%10u %12.3f %12.3f  %s\n", funcs[i].Calls, funcs[i].Exclusive / 1e6, funcs[i].Inclusive / 1e6, funcs[i].Label.GetChars());
+	}
+}
+
+//==========================================================================
+//
+// DumpProfile
+//
+// Writes the call tree in the collapsed stack format that flamegraph.pl
+// and compatible tools read: one line per call path, with the frames
+// separated by semicolons, followed by the exclusive time in microseconds.
+//
+//==========================================================================
+
+static void DumpProfile(const char *filename)
+{
+	FILE *f = fopen(filename, "w");
+	if (f == nullptr)
+	{
+		Printf(TEXTCOLOR_RED "Could not open %s for writing\n", filename);
+		return;
+	}
+
+	TArray<int> path;
+	for (unsigned i = 1; i < ProfileNodes.Size(); i++)
+	{
+		uint64_t exclusive = (ProfileNodes[i].Inclusive - ProfileNodes[i].Callees) / 1000;
+		if (exclusive == 0) continue;
+
+		path.Clear();
+		for (int p = i; p > 0; p = ProfileNodes[p].Parent)
+		{
+			path.Push(p);
+		}
+		FString line;
+		for (int j = path.Size() - 1; j >= 0; j--)
+		{
+			line << ProfileNodes[path[j]].Label;
+			if (j > 0) line << ";";
+		}
+		fprintf(f, "%s %llu\n", line.GetChars(), (unsigned long long)exclusive);
+	}
+	fclose(f);
+	Printf("Wrote %u call paths to %s\n", ProfileNodes.Size() - 1, filename);
+}
+
+//==========================================================================
+//
+// CCMD vmprofile
+//
+//==========================================================================
+
+CCMD(vmprofile)
+{
+	if (argv.argc() >= 2)
+	{
+		if (stricmp(argv[1], "start") == 0)
+		{
+			StartProfiler();
+			Printf("Script profiler started\n");
+			return;
+		}
+		else if (stricmp(argv[1], "stop") == 0)
+		{
+			if (Profiling) StopProfiler();
+			Printf("Script profiler stopped\n");
+			return;
+		}
+		else if (ProfileNodes.Size() == 0)
+		{
+			Printf("No profile has been recorded\n");
+			return;
+		}
+		else if (stricmp(argv[1], "top") == 0)
+		{
+			PrintProfile(argv.argc() > 2 ? (unsigned)MAX(1, atoi(argv[2])) : 20u);
+			return;
+		}
+		else if (stricmp(argv[1], "dump") == 0 && argv.argc() > 2)
+		{
+			DumpProfile(argv[2]);
+			return;
+		}
+	}
+	Printf("Usage: vmprofile start|stop|top [count]|dump <filename>\n");
+}
@@ -224,7 +224,7 @@ public:
 void I_InitSound ()
 {
 	/* Get command line options: */
-	nosound = !!Args->CheckParm ("-nosound");
+	nosound = !!Args->CheckParm ("-nosound") || !!Args->CheckParm ("-benchdemo");
 	nosfx = !!Args->CheckParm ("-nosfx");
 
 	GSnd = NULL;
@@ -52,6 +52,9 @@
 #include "md5.h"
 #include "doomstat.h"
 #include "vm.h"
+#include "ctpl.h"
+#include "stats.h"
+#include "templates.h"
 
 // MACROS ------------------------------------------------------------------
 
@@ -81,6 +84,21 @@ FWadCollection Wads;
 
 // PRIVATE DATA DEFINITIONS ------------------------------------------------
 
+// With -hashfiles, the checksums are calculated on a thread pool. Whole
+// files are hashed by opening them again on the worker threads as soon
+// as InitMultipleFiles starts. Lumps are read on the main thread and
+// hashed in batches.
+struct FHashResult
+{
+	uint8_t Sum[16];
+	long Size;
+	bool Valid;
+};
+
+static ctpl::thread_pool *HashPool;
+static TArray<FString> HashJobNames;
+static std::vector<std::future<FHashResult>> HashJobs;
+
 // CODE --------------------------------------------------------------------
 
 //==========================================================================
@@ -142,12 +160,49 @@ void FWadCollection::InitMultipleFiles (TArray<FString> &filenames)
 	DeleteAll();
 	numfiles = 0;
 
+	if (hashfile)
+	{
+		HashPool = new ctpl::thread_pool(MAX<int>(1, std::thread::hardware_concurrency()));
+		for (unsigned i = 0; i < filenames.Size(); i++)
+		{
+			bool isdir;
+			if (DirEntryExists(filenames[i], &isdir) && !isdir)
+			{
+				const char *name = filenames[i].GetChars();
+				HashJobNames.Push(filenames[i]);
+				HashJobs.push_back(HashPool->push([=](int) -> FHashResult
+				{
+					FHashResult result = {};
+					FileReader fr;
+					if (fr.OpenFile(name))
+					{
+						MD5Context md5;
+						md5.Update(fr, (unsigned)fr.GetLength());
+						md5.Final(result.Sum);
+						result.Size = (long)fr.GetLength();
+						result.Valid = true;
+					}
+					return result;
+				}));
+			}
+		}
+	}
+
 	for(unsigned i=0;i<filenames.Size(); i++)
 	{
 		int baselump = NumLumps;
 		AddFile (filenames[i]);
 	}
 
+	if (HashPool != nullptr)
+	{
+		for (auto &job : HashJobs) if (job.valid()) job.wait();
+		HashJobs.clear();
+		HashJobNames.Clear();
+		delete HashPool;
+		HashPool = nullptr;
+	}
+
 	NumLumps = LumpInfo.Size();
 	if (NumLumps == 0)
 	{
@@ -216,7 +271,12 @@ void FWadCollection::AddFile (const char *filename, FileReader *wadr)
 
 		if (!isdir)
 		{
-			if (!wadreader.OpenFile(filename))
+			// With -mmap, resource files are mapped into memory if possible, so that stored
+			// lumps can be used in place instead of being copied into their own buffers.
+			// This is opt-in: a mapped file that gets truncated while the game runs
+			// crashes it, and on Windows the mapping keeps the file from being replaced.
+			static bool usemmap = !!Args->CheckParm("-mmap");
+			if ((!usemmap || !wadreader.OpenMappedFile(filename)) && !wadreader.OpenFile(filename))
 			{ // Didn't find file
 				Printf (TEXTCOLOR_RED "%s: File not found\n", filename);
 				PrintLastError ();
@@ -270,51 +330,113 @@ void FWadCollection::AddFile (const char *filename, FileReader *wadr)
 
 		if (hashfile)
 		{
-			uint8_t cksum[16];
-			char cksumout[33];
-			memset(cksumout, 0, sizeof(cksumout));
-
-			if (wadreader.isOpen())
-			{
-				MD5Context md5;
-				wadreader.Seek(0, FileReader::SeekSet);
-				md5.Update(wadreader, (unsigned)wadreader.GetLength());
-				md5.Final(cksum);
+			HashFileContents(filename, resfile);
+		}
+		return;
+	}
+}
 
-				for (size_t j = 0; j < sizeof(cksum); ++j)
-				{
-					sprintf(cksumout + (j * 2), "%02X", cksum[j]);
-				}
+//==========================================================================
+//
+// HashFileContents
+//
+// Writes the MD5 sums of a newly added file and its lumps to the
+// -hashfiles output. The output is the same as if everything was hashed
+// in order on one thread.
+//
+//==========================================================================
 
-				fprintf(hashfile, "file: %s, hash: %s, size: %d\n", filename, cksumout, (int)wadreader.GetLength());
-			}
+static void PrintHash(char *cksumout, const uint8_t *cksum)
+{
+	for (size_t j = 0; j < 16; ++j)
+	{
+		sprintf(cksumout + (j * 2), "%02X", cksum[j]);
+	}
+}
 
-			else
-				fprintf(hashfile, "file: %s, Directory structure\n", filename);
+void FWadCollection::HashFileContents(const char *filename, FResourceFile *resfile)
+{
+	enum { BATCH_BYTES = 64 << 20, BATCH_LUMPS = 256 };
+	char cksumout[33];
+	memset(cksumout, 0, sizeof(cksumout));
 
-			for (uint32_t i = 0; i < resfile->LumpCount(); i++)
-			{
-				FResourceLump *lump = resfile->GetLump(i);
+	FHashResult result = {};
+	unsigned job;
+	for (job = 0; job < HashJobNames.Size(); job++)
+	{
+		if (HashJobNames[job].CompareNoCase(filename) == 0 && HashJobs[job].valid()) break;
+	}
+	if (job < HashJobNames.Size())
+	{
+		result = HashJobs[job].get();
+	}
+	else if (resfile->GetReader() != nullptr)
+	{
+		// Embedded files and files added later are hashed right here.
+		FileReader *reader = resfile->GetReader();
+		MD5Context md5;
+		reader->Seek(0, FileReader::SeekSet);
+		md5.Update(*reader, (unsigned)reader->GetLength());
+		md5.Final(result.Sum);
+		result.Size = (long)reader->GetLength();
+		result.Valid = true;
+	}
 
-				if (!(lump->Flags & LUMPF_EMBEDDED))
-				{
-					MD5Context md5;
-					auto reader = lump->NewReader();
-					md5.Update(reader, lump->LumpSize);
-					md5.Final(cksum);
+	if (result.Valid)
+	{
+		PrintHash(cksumout, result.Sum);
+		fprintf(hashfile, "file: %s, hash: %s, size: %d\n", filename, cksumout, (int)result.Size);
+	}
+	else
+		fprintf(hashfile, "file: %s, Directory structure\n", filename);
 
-					for (size_t j = 0; j < sizeof(cksum); ++j)
-					{
-						sprintf(cksumout + (j * 2), "%02X", cksum[j]);
-					}
+	// Reading the lumps has to happen on this thread because they share the
+	// archive's reader, but the checksums can be calculated in parallel.
+	TArray<FResourceLump *> lumps;
+	TArray<TArray<uint8_t>> data;
+	TArray<FHashResult> sums;
+	uint32_t next = 0;
 
-					fprintf(hashfile, "file: %s, lump: %s, hash: %s, size: %d\n", filename,
-						lump->FullName.IsNotEmpty() ? lump->FullName.GetChars() : lump->Name,
-						cksumout, lump->LumpSize);
-				}
+	while (next < resfile->LumpCount())
+	{
+		size_t bytes = 0;
+		lumps.Clear();
+		data.Clear();
+		for (; next < resfile->LumpCount() && lumps.Size() < BATCH_LUMPS && bytes < BATCH_BYTES; next++)
+		{
+			FResourceLump *lump = resfile->GetLump(next);
+			if (!(lump->Flags & LUMPF_EMBEDDED))
+			{
+				auto reader = lump->NewReader();
+				lumps.Push(lump);
+				data.Push(reader.Read(lump->LumpSize));
+				bytes += lump->LumpSize;
 			}
 		}
-		return;
+
+		sums.Resize(lumps.Size());
+		std::vector<std::future<void>> jobs;
+		for (unsigned i = 0; i < lumps.Size(); i++)
+		{
+			TArray<uint8_t> *buffer = &data[i];
+			FHashResult *sum = &sums[i];
+			auto hash = [=](int)
+			{
+				MD5Context md5;
+				md5.Update(buffer->Data(), buffer->Size());
+				md5.Final(sum->Sum);
+			};
+			if (HashPool != nullptr) jobs.push_back(HashPool->push(hash));
+			else hash(0);
+		}
+		for (unsigned i = 0; i < lumps.Size(); i++)
+		{
+			if (i < jobs.size()) jobs[i].wait();
+			PrintHash(cksumout, sums[i].Sum);
+			fprintf(hashfile, "file: %s, lump: %s, hash: %s, size: %d\n", filename,
+				lumps[i]->FullName.IsNotEmpty() ? lumps[i]->FullName.GetChars() : lumps[i]->Name,
+				cksumout, lumps[i]->LumpSize);
+		}
 	}
 }
 
@@ -1590,6 +1712,40 @@ static void PrintLastError ()
 }
 #endif
 
+//==========================================================================
+//
+// Lump cache statistics
+//
+//==========================================================================
+
+ADD_STAT(lumpcache)
+{
+	unsigned hits = 0, misses = 0;
+	uint64_t evicted = 0;
+	for (int i = 0; i < Wads.GetNumWads(); i++)
+	{
+		auto resfile = Wads.GetResourceFile(i);
+		hits += resfile->CacheHits;
+		misses += resfile->CacheMisses;
+		evicted += resfile->EvictedBytes;
+	}
+	return FStringf("Lump cache: %u hits, %u misses, %llu kB evicted, %llu kB released but kept",
+		hits, misses, (unsigned long long)evicted >> 10, (unsigned long long)FResourceLump::CachedBytes() >> 10);
+}
+
+CCMD(lumpcachestats)
+{
+	Printf(TEXTCOLOR_YELLOW "%10s %10s %12s  %s\n", "hits", "misses", "evicted kB", "file");
+	for (int i = 0; i < Wads.GetNumWads(); i++)
+	{
+		auto resfile = Wads.GetResourceFile(i);
+		if (resfile->CacheHits == 0 && resfile->CacheMisses == 0) continue;
+		Printf("%10u %10u %12llu  %s\n", resfile->CacheHits, resfile->CacheMisses,
+			(unsigned long long)resfile->EvictedBytes >> 10, resfile->FileName.GetChars());
+	}
+	Printf("%llu kB of released lumps are kept\n", (unsigned long long)FResourceLump::CachedBytes() >> 10);
+}
+
 #ifdef _DEBUG
 //==========================================================================
 //
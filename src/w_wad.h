@@ -178,6 +178,7 @@ public:
 
 	int GetNumLumps () const;
 	int GetNumWads () const;
+	FResourceFile *GetResourceFile (int wadnum) const { return (unsigned)wadnum < Files.Size() ? Files[wadnum] : nullptr; }
 
 	int AddExternalFile(const char *filename);
 
@@ -210,6 +211,7 @@ private:
 	void RenameNerve();
 	void FixMacHexen();
 	void DeleteAll();
+	void HashFileContents(const char *filename, FResourceFile *resfile);
 	FileReader * GetFileReader(int wadnum);	// Gets a FileReader object to the entire WAD
 };
 